@@ -1,15 +1,38 @@
 #include "algorithm.hpp"
+#include <chrono>
 
 bool algorithm::continue_map(graph *cur_set)
 {
 	if (!sys)
 		return false;
+	sys->refresh_world();
 	return continue_map_internal(cur_set);
 }
 
+bool algorithm::grow_map(graph *cur_set, uint num_new)
+{
+	if (!sys)
+		return false;
+	sys->refresh_world();
+	return grow_map_internal(cur_set, num_new);
+}
+
 graph *algorithm::init_algo(system_nd *new_sys)
 {
 	sys = new_sys;
+	get_planner_stats().set_threads(get_pool()->size());
+	sys->set_threads(get_pool()->size());
+	sys->refresh_world();
+	if (use_cspace_grid)
+		sys->build_occupancy(get_pool());
+	else
+		sys->drop_occupancy();
+
+	sys->use_edge_cache(use_edge_cache);
+	cache_at_init = {};
+	if (sys->get_edge_cache())
+		cache_at_init = sys->get_edge_cache()->get_stats();
+
 	uint q_size = new_sys->get_q_size();
 	float *dims_low = new_sys->get_dims_low();
 	float *dims_high = new_sys->get_dims_high();
@@ -20,6 +43,142 @@ graph *algorithm::init_algo(system_nd *new_sys)
 		    dims_low[i], dims_high[i]));
 
 	generator->seed(seed);
+	sample_rounds = 0;
+	stats = {};
 	graph *g = init_algo_internal(new_sys);
 	return g ? g : new graph(sys->get_q_size());
-}
\ No newline at end of file
+}
+cache_stats algorithm::get_edge_cache_stats()
+{
+	if (!sys || !sys->get_edge_cache())
+		return {};
+
+	cache_stats stats = sys->get_edge_cache()->get_stats();
+
+	/* Emptied for a new scene since */
+	if (stats.hits < cache_at_init.hits ||
+	    stats.misses < cache_at_init.misses)
+		return stats;
+
+	stats.hits -= cache_at_init.hits;
+	stats.misses -= cache_at_init.misses;
+	return stats;
+}
+
+std::vector<float> algorithm::find_path(graph *cur_set, system_nd *sys,
+					float *start, float *finish)
+{
+	phase_timer timer(PHASE_QUERY);
+	return build_path(cur_set, sys, start, finish,
+			  get_connection_radius(sys), &search);
+}
+
+std::vector<query_result> algorithm::find_paths(graph *cur_set,
+						system_nd *sys,
+						const float *starts,
+						const float *finishes,
+						uint count)
+{
+	std::vector<query_result> results(count);
+	thread_pool *cur_pool = get_pool();
+	uint q_size = cur_set->q_size;
+	float con_r_sq = get_connection_radius(sys);
+
+	/* Also flattens the components, so lookups stop writing */
+	if (!cur_set->is_frozen())
+		cur_set->freeze();
+	sys->refresh_world();
+	query_states.resize(cur_pool->size());
+
+	cur_pool->run(count, [&](uint task, uint thread) {
+		phase_timer timer(PHASE_QUERY);
+		auto t0 = std::chrono::steady_clock::now();
+		std::vector<float> start(starts + task * q_size,
+					 starts + (task + 1) * q_size);
+		std::vector<float> finish(finishes + task * q_size,
+					  finishes + (task + 1) * q_size);
+
+		results[task].path =
+		    build_path(cur_set, sys, start.data(), finish.data(),
+			       con_r_sq, &query_states[thread]);
+
+		auto t1 = std::chrono::steady_clock::now();
+		results[task].time_ms =
+		    std::chrono::duration<double, std::milli>(t1 - t0).count();
+	});
+
+	return results;
+}
+
+thread_pool *algorithm::get_pool()
+{
+	uint wanted = num_threads ? num_threads : hardware_threads();
+
+	if (!pool || pool->size() != wanted)
+		pool.reset(new thread_pool(wanted));
+
+	return pool.get();
+}
+
+/* Strategy attempts per sample before settling for a uniform one */
+#define MAX_STRATEGY_TRIES 1000
+
+/*
+ * Adds count collision-free samples. Every thread fills its own fixed quota
+ * from its own stream, so the result only depends on seed and thread count.
+ * Each call uses fresh streams, so growing a roadmap does not repeat samples.
+ * Strategies that only accept samples near obstacles find none in a free
+ * scene, those samples fall back to uniform ones.
+ */
+void algorithm::sample_free(graph *cur_set, uint count)
+{
+	phase_timer timer(PHASE_SAMPLING);
+	uint q_size = cur_set->q_size;
+	thread_pool *workers = get_pool();
+	uint num_chunks = workers->size();
+	uint first_stream = sample_rounds++ * num_chunks;
+	std::vector<std::vector<float>> chunks(num_chunks);
+	uniform_strategy fallback;
+	std::vector<uint64_t> chunk_calls(num_chunks);
+	std::vector<uint64_t> chunk_fallbacks(num_chunks);
+
+	workers->run(num_chunks, [&](uint chunk, uint) {
+		uint quota = count / num_chunks + (chunk < count % num_chunks);
+		uint stream = first_stream + chunk;
+		sampler_ptr gen(generator->clone());
+		sample_context ctx(sys, gen.get(), ranges.data(), q_size, seed,
+				   stream);
+		std::vector<float> &out = chunks[chunk];
+
+		gen->seed(seed, stream);
+		out.resize(quota * q_size);
+
+		for (uint i = 0; i < quota; i++) {
+			float *cfg = out.data() + i * q_size;
+			uint tries = 0;
+
+			while (tries < MAX_STRATEGY_TRIES &&
+			       !strategy->sample(&ctx, cfg))
+				tries++;
+			if (tries < MAX_STRATEGY_TRIES)
+				continue;
+
+			chunk_fallbacks[chunk]++;
+			while (!fallback.sample(&ctx, cfg))
+				;
+		}
+
+		chunk_calls[chunk] = ctx.valid_calls;
+	});
+
+	for (uint i = 0; i < num_chunks; i++) {
+		stats.valid_calls += chunk_calls[i];
+		stats.fallbacks += chunk_fallbacks[i];
+	}
+	stats.accepted += count;
+
+	cur_set->reserve(cur_set->get_num_verts() + count);
+	for (auto &chunk : chunks)
+		for (uint i = 0; i < chunk.size(); i += q_size)
+			cur_set->add_vertice(chunk.data() + i);
+}
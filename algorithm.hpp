@@ -1,13 +1,19 @@
 #ifndef ALGORITHM_H
 #define ALGORITHM_H
 
+#include "sampling_strategy.hpp"
 #include "shape_collections.hpp"
+#include "thread_pool.hpp"
 #include <random>
 
 class sampler {
       public:
-	virtual void seed(uint seed) = 0;
-	virtual float generate(std::uniform_real_distribution<float> range) = 0;
+	virtual ~sampler() {}
+	/* Different streams give independent sequences for the same seed */
+	virtual void seed(uint seed, uint stream = 0) = 0;
+	virtual sampler *clone() = 0;
+	/* count points of [0, 1)^dim, stored one after another */
+	virtual void generate_batch(float *out, uint count, uint dim) = 0;
 };
 
 typedef std::unique_ptr<sampler> sampler_ptr;
@@ -17,18 +23,31 @@ template <class T> class sampler_imp : public sampler {
 	T generator;
 
       public:
-	virtual void seed(uint seed) override { generator.seed(); }
+	virtual void seed(uint seed, uint stream) override
+	{
+		std::seed_seq seq{seed, stream};
+		generator.seed(seq);
+	}
+
+	virtual sampler *clone() override { return new sampler_imp<T>(*this); }
 
-	virtual float
-	generate(std::uniform_real_distribution<float> range) override
+	virtual void generate_batch(float *out, uint count, uint dim) override
 	{
-		return range(generator);
+		std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+		for (uint i = 0; i < count * dim; i++)
+			out[i] = unit(generator);
 	}
 };
 
 /* Allowed number generators */
 template class sampler_imp<std::mt19937>;
 
+struct query_result {
+	std::vector<float> path; /* empty if no path was found */
+	double time_ms;
+};
+
 class algorithm {
       protected:
 	system_nd *sys = NULL;
@@ -37,20 +56,66 @@ class algorithm {
 	{
 		return nullptr;
 	}
+	virtual bool grow_map_internal(graph *cur_set, uint num_new)
+	{
+		return false;
+	}
 	std::vector<std::uniform_real_distribution<float>> ranges;
 	sampler_ptr generator;
-	uint seed;
+	uint seed = 0;
+	uint num_threads = 0;
+	uint sample_rounds = 0;
+	bool use_cspace_grid = false;
+	bool use_edge_cache = false;
+	cache_stats cache_at_init;
+	std::unique_ptr<sampling_strategy> strategy{new uniform_strategy};
+	sampling_stats stats;
+	std::unique_ptr<thread_pool> pool;
+	search_state search;
+	std::vector<search_state> query_states; /* one per pool thread */
+	thread_pool *get_pool();
+	void sample_free(graph *cur_set, uint count);
 
       public:
 	bool continue_map(graph *cur_set);
 	graph *init_algo(system_nd *new_sys);
+	/* Adds num_new samples to a finished roadmap, continue_map connects */
+	bool grow_map(graph *cur_set, uint num_new);
+	virtual bool can_grow() { return false; }
+	void set_seed(uint new_seed) { seed = new_seed; }
+	void set_sampler(sampler *new_sampler) { generator.reset(new_sampler); }
+	void set_strategy(sampling_strategy *new_strategy)
+	{
+		strategy.reset(new_strategy);
+	}
+	sampling_stats get_sampling_stats() { return stats; }
+	/* 0 uses all hardware threads, results depend on seed and count */
+	void set_num_threads(uint count) { num_threads = count; }
+	/* Occupancy grid in front of the checks, low dimensional systems */
+	void set_cspace_grid(bool enable) { use_cspace_grid = enable; }
+	/* Edge results kept by the system, reused by later runs on it */
+	void set_edge_cache(bool enable) { use_edge_cache = enable; }
+	/* Lookups since init_algo */
+	cache_stats get_edge_cache_stats();
 
 	algorithm(sampler *sampler = new sampler_imp<std::mt19937>)
 	{
 		generator.reset(sampler);
 	}
+	virtual ~algorithm() = default;
 
 	virtual float get_connection_radius(system_nd *sys) = 0;
+	virtual std::vector<float> find_path(graph *cur_set, system_nd *sys,
+					     float *start, float *finish);
+	/*
+	 * count queries, q_size floats each in starts and finishes, answered
+	 * in parallel. Freezes cur_set, which is only read during the batch.
+	 */
+	virtual std::vector<query_result> find_paths(graph *cur_set,
+						     system_nd *sys,
+						     const float *starts,
+						     const float *finishes,
+						     uint count);
 };
 
 #endif
\ No newline at end of file
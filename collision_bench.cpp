@@ -0,0 +1,145 @@
+/*
+ * Microbenchmark for the segment kernels, builds without SDL or OpenGL:
+ * make collision_bench && ./collision_bench [num_circles] [num_segments]
+ */
+#include "segment_kernel.hpp"
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct segment {
+	float x1, y1, x2, y2;
+};
+
+/* Exact distance test in doubles, the way the old per-obstacle loop did */
+static bool touches(const circle_soa &c, uint k, const segment &s)
+{
+	double dx = s.x2 - s.x1;
+	double dy = s.y2 - s.y1;
+	double px = c.x[k] - s.x1;
+	double py = c.y[k] - s.y1;
+	double len_sq = dx * dx + dy * dy;
+	double t = len_sq > 0. ? (px * dx + py * dy) / len_sq : 0.;
+
+	t = t < 0. ? 0. : t > 1. ? 1. : t;
+	double ex = px - t * dx;
+	double ey = py - t * dy;
+
+	return ex * ex + ey * ey <= (double)c.r[k] * c.r[k];
+}
+
+struct bench_result {
+	double ms;
+	unsigned long hits;
+	unsigned long hash;
+};
+
+static bench_result run_kernel(segment_kernel kernel, const circle_soa &c,
+			       std::vector<segment> &segs, uint *missed)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	bench_result res = {0., 0, 0};
+	uint n = c.size();
+
+	for (uint i = 0; i < segs.size(); i++) {
+		segment &s = segs[i];
+		uint k = 0;
+
+		while ((k = kernel(c, k, n, s.x1, s.y1, s.x2, s.y2)) < n) {
+			res.hits++;
+			res.hash = res.hash * 31 + k;
+			k++;
+		}
+	}
+
+	auto t1 = std::chrono::steady_clock::now();
+	res.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+	/* Every exact hit has to be among the candidates */
+	*missed = 0;
+	for (uint i = 0; i < segs.size(); i++) {
+		segment &s = segs[i];
+		uint k = 0;
+
+		for (uint j = 0; j < n; j++) {
+			if (!touches(c, j, s))
+				continue;
+			k = kernel(c, j, n, s.x1, s.y1, s.x2, s.y2);
+			*missed += k != j;
+		}
+	}
+
+	return res;
+}
+
+int main(int argc, char **argv)
+{
+	uint num_circles = argc > 1 ? atoi(argv[1]) : 4096;
+	uint num_segs = argc > 2 ? atoi(argv[2]) : 20000;
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> x_dist(0.f, 400.f);
+	std::uniform_real_distribution<float> y_dist(0.f, 225.f);
+	std::uniform_real_distribution<float> r_dist(0.5f, 3.f);
+	std::uniform_real_distribution<float> d_dist(-30.f, 30.f);
+	circle_soa circles;
+	std::vector<segment> segs(num_segs);
+
+	for (uint i = 0; i < num_circles; i++)
+		circles.push(x_dist(gen), y_dist(gen), r_dist(gen));
+	for (auto &s : segs) {
+		s.x1 = x_dist(gen);
+		s.y1 = y_dist(gen);
+		s.x2 = s.x1 + d_dist(gen);
+		s.y2 = s.y1 + d_dist(gen);
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	unsigned long exact_hits = 0;
+	for (auto &s : segs)
+		for (uint k = 0; k < num_circles; k++)
+			exact_hits += touches(circles, k, s);
+	auto t1 = std::chrono::steady_clock::now();
+	double exact_ms =
+	    std::chrono::duration<double, std::milli>(t1 - t0).count();
+	double num_tests = (double)num_circles * num_segs;
+
+	printf("%u circles x %u segments\n", num_circles, num_segs);
+	printf("%-8s %10.2f ms %6.2f ns/test hits %lu\n", "double",
+	       exact_ms, exact_ms * 1e6 / num_tests, exact_hits);
+
+	segment_kernel kernels[] = {
+	    segment_kernel_scalar,
+#ifdef HAVE_AVX2_KERNEL
+	    segment_kernel_avx2,
+#endif
+	};
+	bench_result base = {};
+
+	for (segment_kernel kernel : kernels) {
+		const char *name = segment_kernel_name(kernel);
+		uint missed;
+
+#ifdef HAVE_AVX2_KERNEL
+		if (kernel == segment_kernel_avx2 &&
+		    !__builtin_cpu_supports("avx2")) {
+			printf("%-8s not supported here\n", name);
+			continue;
+		}
+#endif
+		bench_result res = run_kernel(kernel, circles, segs, &missed);
+		if (kernel == segment_kernel_scalar)
+			base = res;
+
+		printf("%-8s %10.2f ms %6.2f ns/test candidates %lu missed %u "
+		       "same as scalar %s speedup %.2fx\n",
+		       name, res.ms, res.ms * 1e6 / num_tests, res.hits, missed,
+		       res.hash == base.hash && res.hits == base.hits ? "yes"
+								     : "no",
+		       exact_ms / res.ms);
+	}
+
+	printf("picked %s\n", segment_kernel_name(pick_segment_kernel()));
+	return 0;
+}
@@ -0,0 +1,160 @@
+#include "cspace_grid.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+/* Whole words of both bitsets per task, so tasks never share a word */
+#define CELLS_PER_TASK 4096
+
+cspace_grid::cspace_grid(uint dim, const float *low_in, const float *high,
+			 uint64_t key)
+    : dim(dim), key(key)
+{
+	res = (uint)floorf(powf((float)CSPACE_GRID_CELLS, 1.f / dim) + 1e-3f);
+	num_cells = 1;
+
+	for (uint d = 0; d < dim; d++) {
+		num_cells *= res;
+		low[d] = low_in[d];
+		cell_size[d] = (high[d] - low_in[d]) / res;
+		inv_size[d] = cell_size[d] > 0.f ? 1.f / cell_size[d] : 0.f;
+	}
+
+	free_bits.assign((num_cells + 63) / 64, 0);
+	blocked_bits.assign((num_cells + 63) / 64, 0);
+}
+
+void cspace_grid::fill(thread_pool *pool, const cell_classifier &classify)
+{
+	uint num_tasks = (num_cells + CELLS_PER_TASK - 1) / CELLS_PER_TASK;
+	std::vector<uint> task_free(num_tasks, 0);
+	std::vector<uint> task_blocked(num_tasks, 0);
+
+	auto job = [&](uint task, uint) {
+		uint end = std::min(num_cells, (task + 1) * CELLS_PER_TASK);
+		float cell_low[MAX_CSPACE_DIM];
+		float cell_high[MAX_CSPACE_DIM];
+
+		for (uint cell = task * CELLS_PER_TASK; cell < end; cell++) {
+			uint rest = cell;
+			for (uint d = 0; d < dim; d++, rest /= res) {
+				uint idx = rest % res;
+				cell_low[d] = low[d] + idx * cell_size[d];
+				cell_high[d] = cell_low[d] + cell_size[d];
+			}
+
+			uint64_t bit = (uint64_t)1 << (cell & 63);
+			switch (classify(cell_low, cell_high)) {
+			case CELL_FREE:
+				free_bits[cell >> 6] |= bit;
+				task_free[task]++;
+				break;
+			case CELL_BLOCKED:
+				blocked_bits[cell >> 6] |= bit;
+				task_blocked[task]++;
+				break;
+			default:
+				break;
+			}
+		}
+	};
+
+	if (pool) {
+		pool->run(num_tasks, job);
+	} else {
+		for (uint task = 0; task < num_tasks; task++)
+			job(task, 0);
+	}
+
+	num_free = num_blocked = 0;
+	for (uint task = 0; task < num_tasks; task++) {
+		num_free += task_free[task];
+		num_blocked += task_blocked[task];
+	}
+}
+
+/*
+ * Index and cell bounds are computed differently, so a configuration on a
+ * cell border may land in its neighbour. Classifiers keep a margin that
+ * covers this.
+ */
+cell_state cspace_grid::lookup(const float *cfg) const
+{
+	uint cell = 0;
+	uint stride = 1;
+
+	for (uint d = 0; d < dim; d++, stride *= res) {
+		float f = (cfg[d] - low[d]) * inv_size[d];
+
+		if (!(f >= 0.f && f < (float)res))
+			return CELL_MIXED;
+		cell += (uint)f * stride;
+	}
+
+	return get_state(cell);
+}
+
+/* Walks the cells along the segment, Amanatides and Woo style */
+bool cspace_grid::segment_free(const float *cfg_1, const float *cfg_2) const
+{
+	int idx[MAX_CSPACE_DIM];
+	int end_idx[MAX_CSPACE_DIM];
+	int step[MAX_CSPACE_DIM];
+	float t_max[MAX_CSPACE_DIM];
+	float t_delta[MAX_CSPACE_DIM];
+	uint num_steps = 0;
+
+	for (uint d = 0; d < dim; d++) {
+		float f1 = (cfg_1[d] - low[d]) * inv_size[d];
+		float f2 = (cfg_2[d] - low[d]) * inv_size[d];
+
+		if (!(f1 >= 0.f && f1 < (float)res && f2 >= 0.f &&
+		      f2 < (float)res))
+			return false;
+
+		float diff = f2 - f1;
+		idx[d] = (int)f1;
+		end_idx[d] = (int)f2;
+		step[d] = diff > 0.f ? 1 : diff < 0.f ? -1 : 0;
+		num_steps += abs(end_idx[d] - idx[d]);
+
+		if (!step[d]) {
+			t_max[d] = t_delta[d] = INFINITY;
+			continue;
+		}
+
+		float to_border = step[d] > 0 ? idx[d] + 1 - f1 : f1 - idx[d];
+		t_delta[d] = 1.f / fabsf(diff);
+		t_max[d] = to_border * t_delta[d];
+	}
+
+	for (uint s = 0;; s++) {
+		uint cell = 0;
+		uint stride = 1;
+
+		for (uint d = 0; d < dim; d++, stride *= res)
+			cell += idx[d] * stride;
+		if (get_state(cell) != CELL_FREE)
+			return false;
+		if (s == num_steps)
+			break;
+
+		uint next = 0;
+		for (uint d = 1; d < dim; d++)
+			if (t_max[d] < t_max[next])
+				next = d;
+
+		idx[next] += step[next];
+		t_max[next] += t_delta[next];
+		if (idx[next] < 0 || idx[next] >= (int)res)
+			return false;
+	}
+
+	/* Rounding sent the walk elsewhere, let the exact check decide */
+	for (uint d = 0; d < dim; d++)
+		if (idx[d] != end_idx[d])
+			return false;
+
+	return true;
+}
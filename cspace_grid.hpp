@@ -0,0 +1,78 @@
+#ifndef CSPACE_GRID_H
+#define CSPACE_GRID_H
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+typedef unsigned int uint;
+
+class thread_pool;
+
+enum cell_state {
+	CELL_MIXED = 0, /* unknown, ask the exact check */
+	CELL_FREE,	/* every configuration in the cell is valid */
+	CELL_BLOCKED,	/* every configuration in the cell is invalid */
+};
+
+#define MAX_CSPACE_DIM 3
+/* Total cells, split evenly between the dimensions */
+#define CSPACE_GRID_CELLS (1u << 18)
+
+/* Workspace slack classifiers keep, covers rounding at cell borders */
+#define CELL_MARGIN 1e-2f
+
+/* Classifies the closed box [low, high] of configurations */
+typedef std::function<cell_state(const float *low, const float *high)>
+    cell_classifier;
+
+/*
+ * Occupancy of a low dimensional configuration space as two bitsets over a
+ * regular grid. Filled once, in parallel, and only read afterwards. key
+ * identifies the scene and parameters it was filled for.
+ */
+class cspace_grid {
+      private:
+	uint dim;
+	uint res; /* cells per dimension */
+	float low[MAX_CSPACE_DIM];
+	float cell_size[MAX_CSPACE_DIM];
+	float inv_size[MAX_CSPACE_DIM];
+	std::vector<uint64_t> free_bits;
+	std::vector<uint64_t> blocked_bits;
+	uint num_cells;
+	uint num_free = 0;
+	uint num_blocked = 0;
+
+	cell_state get_state(uint cell) const
+	{
+		uint64_t bit = (uint64_t)1 << (cell & 63);
+
+		if (free_bits[cell >> 6] & bit)
+			return CELL_FREE;
+		if (blocked_bits[cell >> 6] & bit)
+			return CELL_BLOCKED;
+		return CELL_MIXED;
+	}
+
+      public:
+	uint64_t key;
+
+	cspace_grid(uint dim, const float *low, const float *high,
+		    uint64_t key);
+	void fill(thread_pool *pool, const cell_classifier &classify);
+
+	uint get_num_cells() const { return num_cells; }
+	float free_fraction() const { return (float)num_free / num_cells; }
+	float blocked_fraction() const
+	{
+		return (float)num_blocked / num_cells;
+	}
+
+	/* Mixed for configurations outside the grid */
+	cell_state lookup(const float *cfg) const;
+	/* True only if every cell the segment passes through is free */
+	bool segment_free(const float *cfg_1, const float *cfg_2) const;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "disjoint_set.hpp"
+
+void disjoint_set::reset(uint num_elems)
+{
+	parent.resize(num_elems);
+	rank.assign(num_elems, 0);
+	for (uint i = 0; i < num_elems; i++)
+		parent[i] = i;
+	num_sets = num_elems;
+}
+
+void disjoint_set::reserve(uint num_elems)
+{
+	parent.reserve(num_elems);
+	rank.reserve(num_elems);
+}
+
+uint disjoint_set::add()
+{
+	uint id = parent.size();
+	parent.push_back(id);
+	rank.push_back(0);
+	num_sets++;
+	return id;
+}
+
+/*
+ * Compresses the whole path to the root. Elements already pointing at their
+ * root are not written to, so flattened sets can be read from many threads.
+ */
+uint disjoint_set::find(uint id)
+{
+	uint root = id;
+	while (parent[root] != root)
+		root = parent[root];
+
+	while (parent[id] != root) {
+		uint next = parent[id];
+		parent[id] = root;
+		id = next;
+	}
+
+	return root;
+}
+
+bool disjoint_set::unite(uint id1, uint id2)
+{
+	uint root1 = find(id1);
+	uint root2 = find(id2);
+
+	if (root1 == root2)
+		return false;
+
+	if (rank[root1] < rank[root2])
+		std::swap(root1, root2);
+
+	parent[root2] = root1;
+	if (rank[root1] == rank[root2])
+		rank[root1]++;
+
+	num_sets--;
+	return true;
+}
+
+void disjoint_set::flatten()
+{
+	for (uint i = 0; i < parent.size(); i++)
+		find(i);
+}
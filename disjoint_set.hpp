@@ -0,0 +1,29 @@
+#ifndef DISJOINT_SET_H
+#define DISJOINT_SET_H
+
+#include <stdint.h>
+#include <vector>
+
+typedef unsigned int uint;
+
+/* Union-find with union by rank and full path compression */
+class disjoint_set {
+      private:
+	std::vector<uint> parent;
+	std::vector<uint8_t> rank;
+	uint num_sets = 0;
+
+      public:
+	void reset(uint num_elems);
+	void reserve(uint num_elems);
+	uint add();
+	uint find(uint id);
+	bool unite(uint id1, uint id2); /* false if already joined */
+	bool same(uint id1, uint id2) { return find(id1) == find(id2); }
+	/* Points every element straight at its root, see find() */
+	void flatten();
+	uint size() const { return parent.size(); }
+	uint num_components() const { return num_sets; }
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "distance_field.hpp"
+
+/*
+ * Grows the query radius until the nearest circle found lies within it, all
+ * circles the grid does not report are then further away.
+ */
+float nearest_obstacle(const obstacle_grid &grid, point p, float r_guess)
+{
+	if (!grid.size())
+		return distance_field::NO_OBSTACLE;
+
+	float r = std::max(r_guess, 1.f);
+
+	while (true) {
+		float best = distance_field::NO_OBSTACLE;
+		uint num_seen = 0;
+
+		grid.any_near_disc({p, r}, [&](uint idx) {
+			const circle &c = grid.get(idx);
+			float dx = p.x - c.center.x;
+			float dy = p.y - c.center.y;
+
+			best = std::min(best, sqrtf(dx * dx + dy * dy) -
+						  c.radius);
+			num_seen++;
+			return false;
+		});
+
+		if (best <= r || num_seen == grid.size())
+			return best;
+		r *= 2.f;
+	}
+}
+
+void distance_field::rebuild(const obstacle_grid &grid)
+{
+	const std::vector<circle> &circles = grid.get_all();
+
+	samples.clear();
+	num_x = num_y = 0;
+	if (circles.empty())
+		return;
+
+	float x_low = circles[0].center.x;
+	float x_high = x_low;
+	float y_low = circles[0].center.y;
+	float y_high = y_low;
+
+	for (const circle &c : circles) {
+		x_low = std::min(x_low, c.center.x - c.radius);
+		x_high = std::max(x_high, c.center.x + c.radius);
+		y_low = std::min(y_low, c.center.y - c.radius);
+		y_high = std::max(y_high, c.center.y + c.radius);
+	}
+
+	cell = std::max(std::max(x_high - x_low, y_high - y_low) / SDF_RES,
+			1e-3f);
+	inv_cell = 1.f / cell;
+	origin = {x_low - cell, y_low - cell};
+	num_x = (int)((x_high - x_low) * inv_cell) + 3;
+	num_y = (int)((y_high - y_low) * inv_cell) + 3;
+	samples.resize(num_x * num_y);
+
+	/* Neighbouring samples differ by at most a cell, a good guess */
+	float guess = cell;
+	for (int y = 0; y < num_y; y++) {
+		for (int x = 0; x < num_x; x++) {
+			point p = {origin.x + x * cell, origin.y + y * cell};
+			float dist = nearest_obstacle(grid, p, guess + cell);
+
+			samples[y * num_x + x] = dist;
+			guess = std::max(dist, 0.f);
+		}
+	}
+}
+
+float distance_field::lower_bound(point p) const
+{
+	if (samples.empty())
+		return NO_OBSTACLE;
+
+	int x = (int)floorf((p.x - origin.x) * inv_cell + 0.5f);
+	int y = (int)floorf((p.y - origin.y) * inv_cell + 0.5f);
+	x = std::min(num_x - 1, std::max(0, x));
+	y = std::min(num_y - 1, std::max(0, y));
+
+	float dx = p.x - (origin.x + x * cell);
+	float dy = p.y - (origin.y + y * cell);
+	return samples[y * num_x + x] - sqrtf(dx * dx + dy * dy);
+}
+
+float distance_field::clearance(const obstacle_grid &grid, point p) const
+{
+	float bound = lower_bound(p);
+
+	if (bound > cell)
+		return bound;
+
+	/* The sample is at most a diagonal away, so is the true distance */
+	return nearest_obstacle(grid, p, std::max(bound, 0.f) + 1.5f * cell);
+}
+
+float segment_point_dist(point p1, point p2, point p)
+{
+	float dx = p2.x - p1.x;
+	float dy = p2.y - p1.y;
+	float len_sq = dx * dx + dy * dy;
+	float t = 0.f;
+
+	if (len_sq > 0.f) {
+		t = ((p.x - p1.x) * dx + (p.y - p1.y) * dy) / len_sq;
+		t = std::min(std::max(t, 0.f), 1.f);
+	}
+
+	float ex = p1.x + t * dx - p.x;
+	float ey = p1.y + t * dy - p.y;
+	return sqrtf(ex * ex + ey * ey);
+}
+
+/*
+ * The bound at the midpoint less half the length covers the whole segment,
+ * one lookup far from obstacles. Otherwise the circles within target of the
+ * segment give the exact value.
+ */
+float distance_field::segment_clearance(const obstacle_grid &grid, point p1,
+					point p2, float target) const
+{
+	float dx = p2.x - p1.x;
+	float dy = p2.y - p1.y;
+	point mid = {p1.x + 0.5f * dx, p1.y + 0.5f * dy};
+	float bound = lower_bound(mid) - 0.5f * sqrtf(dx * dx + dy * dy);
+
+	if (bound >= target)
+		return bound;
+
+	bound = target;
+	grid.any_near_segment(p1, p2, bound, [&](uint idx) {
+		const circle &c = grid.get(idx);
+
+		bound = std::min(bound, segment_point_dist(p1, p2, c.center) -
+					    c.radius);
+		return bound <= 0.f;
+	});
+
+	return bound;
+}
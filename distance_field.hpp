@@ -0,0 +1,85 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "obstacle_grid.hpp"
+#include <limits>
+#include <vector>
+
+/* Samples along the longer side of the obstacles' bounds */
+#define SDF_RES 128
+/* Clearance certified moves give away, covers float rounding */
+#define SDF_MARGIN 1e-2f
+/* Conservative advancement steps per edge end */
+#define MAX_ADVANCE_STEPS 16
+
+/*
+ * Signed distance to the nearest obstacle circle, sampled on a regular
+ * grid over the obstacles' bounds. Distance changes by at most the distance
+ * moved, so a sample minus how far it is from a point bounds the point from
+ * below, also outside the sampled bounds. Near obstacles the circles from
+ * obstacle_grid give the exact value instead. Read only once built.
+ */
+class distance_field {
+      private:
+	std::vector<float> samples;
+	point origin = {0.f, 0.f};
+	float cell = 1.f;
+	float inv_cell = 1.f;
+	int num_x = 0;
+	int num_y = 0;
+
+      public:
+	/* Clearance when there are no obstacles */
+	static constexpr float NO_OBSTACLE = std::numeric_limits<float>::max();
+
+	void rebuild(const obstacle_grid &grid);
+	/* Never more than the distance from p to the nearest obstacle */
+	float lower_bound(point p) const;
+	/* As lower_bound, exact when p is within about a sample of obstacles */
+	float clearance(const obstacle_grid &grid, point p) const;
+	/*
+	 * Lower bound for every point of the segment p1-p2, exact where it
+	 * is below target
+	 */
+	float segment_clearance(const obstacle_grid &grid, point p1, point p2,
+				float target) const;
+};
+
+/* Exact signed distance from p to the nearest circle of grid */
+float nearest_obstacle(const obstacle_grid &grid, point p, float r_guess);
+float segment_point_dist(point p1, point p2, point p);
+
+/*
+ * Conservative advancement over an edge parametrised by t in [0, 1] from
+ * both ends. step_at(t, left) gives how far t may move from the pose at t
+ * with the robot staying free, left is the part still uncertified. A side
+ * stops once its steps fall under min_step. [*lo, *hi] is what remains
+ * uncertified, the whole edge is free when lo >= hi.
+ */
+template <class F>
+void advance_edge(F step_at, float min_step, float *lo, float *hi)
+{
+	bool lo_open = true;
+	bool hi_open = true;
+
+	*lo = 0.f;
+	*hi = 1.f;
+	for (uint k = 0; k < 2 * MAX_ADVANCE_STEPS && (lo_open || hi_open) &&
+			 *lo < *hi;
+	     k++) {
+		bool from_lo = lo_open && (!hi_open || !(k & 1));
+		float step = step_at(from_lo ? *lo : *hi, *hi - *lo);
+
+		if (!(step >= min_step)) {
+			(from_lo ? lo_open : hi_open) = false;
+			continue;
+		}
+
+		if (from_lo)
+			*lo += step;
+		else
+			*hi -= step;
+	}
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "edge_cache.hpp"
+#include <string.h>
+
+edge_cache::edge_cache(uint q_size)
+    : q_size(q_size), shards(new shard[EDGE_CACHE_SHARDS])
+{
+}
+
+/* Mixes the float bit patterns, so equal coordinates hash alike */
+uint64_t edge_cache::pair_hash(const float *cfg_1, const float *cfg_2,
+			       uint64_t seed)
+{
+	uint64_t hash = seed ^ 0x9e3779b97f4a7c15ull;
+
+	for (uint i = 0; i < 2 * q_size; i++) {
+		uint32_t bits;
+
+		memcpy(&bits, i < q_size ? cfg_1 + i : cfg_2 + i - q_size,
+		       sizeof(bits));
+		hash = (hash ^ bits) * 0xff51afd7ed558ccdull;
+		hash ^= hash >> 32;
+	}
+
+	return hash;
+}
+
+void edge_cache::set_scene(uint64_t scene_key)
+{
+	if (scene_key == scene)
+		return;
+
+	clear();
+	scene = scene_key;
+}
+
+void edge_cache::clear()
+{
+	for (uint i = 0; i < EDGE_CACHE_SHARDS; i++) {
+		shards[i].results.clear();
+		shards[i].hits = 0;
+		shards[i].misses = 0;
+	}
+}
+
+cache_stats edge_cache::get_stats()
+{
+	cache_stats stats;
+
+	for (uint i = 0; i < EDGE_CACHE_SHARDS; i++) {
+		std::lock_guard<std::mutex> guard(shards[i].lock);
+		stats.hits += shards[i].hits;
+		stats.misses += shards[i].misses;
+	}
+
+	return stats;
+}
@@ -0,0 +1,96 @@
+#ifndef EDGE_CACHE_H
+#define EDGE_CACHE_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+
+typedef unsigned int uint;
+
+/* Independently locked parts, threads rarely wait on each other */
+#define EDGE_CACHE_SHARDS 64
+/* A shard is emptied once it holds more results than its share of this */
+#define EDGE_CACHE_MAX (1u << 22)
+
+struct cache_stats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+
+	float hit_rate()
+	{
+		uint64_t total = hits + misses;
+		return total ? (float)hits / (float)total : 0.f;
+	}
+};
+
+/*
+ * Results of edge checks by configuration pair. Edge checks are symmetric, so
+ * a pair is hashed with its lexicographically smaller end first and found in
+ * either order. Pairs are keyed by a 64-bit hash of their coordinates, and a
+ * second 31-bit hash stored with the result catches key collisions. Every
+ * result is for one scene, see set_scene(). Lookups may come from several
+ * threads at once.
+ */
+class edge_cache {
+      private:
+	struct shard {
+		std::mutex lock;
+		/* Check hash in the high bits, validity in bit 0 */
+		std::unordered_map<uint64_t, uint32_t> results;
+		uint64_t hits = 0; /* under lock, like results */
+		uint64_t misses = 0;
+	};
+
+	uint q_size;
+	uint64_t scene = 0;
+	std::unique_ptr<shard[]> shards;
+
+	uint64_t pair_hash(const float *cfg_1, const float *cfg_2,
+			   uint64_t seed);
+
+      public:
+	edge_cache(uint q_size);
+	/* Not thread safe, drops all results when scene_key is a new scene */
+	void set_scene(uint64_t scene_key);
+	void clear();
+	cache_stats get_stats();
+
+	/* Cached result for the pair, check(cfg_1, cfg_2) if there is none */
+	template <class F>
+	bool get_or_check(float *cfg_1, float *cfg_2, F check)
+	{
+		const float *low = cfg_1;
+		const float *high = cfg_2;
+
+		if (std::lexicographical_compare(cfg_2, cfg_2 + q_size, cfg_1,
+						 cfg_1 + q_size))
+			std::swap(low, high);
+
+		uint64_t key = pair_hash(low, high, 0);
+		uint32_t tag = (uint32_t)pair_hash(low, high, key) << 1;
+		shard &part = shards[key % EDGE_CACHE_SHARDS];
+
+		{
+			std::lock_guard<std::mutex> guard(part.lock);
+			auto found = part.results.find(key);
+			if (found != part.results.end() &&
+			    (found->second & ~1u) == tag) {
+				part.hits++;
+				return found->second & 1u;
+			}
+		}
+
+		bool valid = check(cfg_1, cfg_2);
+
+		std::lock_guard<std::mutex> guard(part.lock);
+		part.misses++;
+		if (part.results.size() >= EDGE_CACHE_MAX / EDGE_CACHE_SHARDS)
+			part.results.clear();
+		part.results[key] = tag | (uint32_t)valid;
+		return valid;
+	}
+};
+
+#endif
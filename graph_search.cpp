@@ -0,0 +1,193 @@
+#include "graph_search.hpp"
+#include "shape_collections.hpp"
+#include <algorithm>
+#include <math.h>
+
+static float get_dist(const float *v1, const float *v2, uint size)
+{
+	float dist_sq = 0.f;
+
+	for (uint j = 0; j < size; j++)
+		dist_sq += (v1[j] - v2[j]) * (v1[j] - v2[j]);
+
+	return sqrtf(dist_sq);
+}
+
+void search_state::begin(uint num_verts)
+{
+	if (stamp.size() < num_verts) {
+		stamp.resize(num_verts, generation);
+		cost.resize(num_verts);
+		heuristic.resize(num_verts);
+		through.resize(num_verts);
+		closed.resize(num_verts, generation);
+	}
+
+	/* Old stamps could match again once the counter wraps */
+	if (++generation == 0) {
+		std::fill(stamp.begin(), stamp.end(), 0);
+		std::fill(closed.begin(), closed.end(), 0);
+		generation = 1;
+	}
+
+	open.clear();
+	lazy_open.clear();
+	num_expanded = 0;
+	path_cost = 0.f;
+}
+
+std::vector<uint> search_state::trace(uint start, uint finish)
+{
+	std::vector<uint> full_path;
+
+	for (uint cur_id = finish; cur_id != start; cur_id = through[cur_id])
+		full_path.push_back(cur_id);
+	full_path.push_back(start);
+
+	std::reverse(full_path.begin(), full_path.end());
+	path_cost = cost[finish];
+
+	return full_path;
+}
+
+/*
+ * Stale heap entries are skipped instead of decreasing keys. A vertex whose
+ * cost still improves after expansion (float rounding can make the heuristic
+ * very slightly inconsistent) is simply expanded again.
+ */
+std::vector<uint> astar_path(graph *g, uint start, uint finish,
+			     search_state *state)
+{
+	search_state local_state;
+	search_state &s = state ? *state : local_state;
+	uint q_size = g->q_size;
+	float *goal = g->get_vertice(finish);
+	auto open_greater = [](const search_state::open_node &n1,
+			       const search_state::open_node &n2) {
+		return n1.est > n2.est;
+	};
+
+	s.begin(g->get_num_verts());
+	s.stamp[start] = s.generation;
+	s.cost[start] = 0.f;
+	s.through[start] = start;
+	s.open.push_back(
+	    {get_dist(g->get_vertice(start), goal, q_size), 0.f, start});
+
+	bool found = false;
+
+	while (!s.open.empty()) {
+		std::pop_heap(s.open.begin(), s.open.end(), open_greater);
+		search_state::open_node node = s.open.back();
+		s.open.pop_back();
+
+		if (node.cost > s.cost[node.idx])
+			continue;
+		if (node.idx == finish) {
+			found = true;
+			break;
+		}
+
+		s.num_expanded++;
+		neigh_range neighs = g->neighbours(node.idx);
+		const float *weights = g->neighbour_weights(node.idx);
+
+		for (uint k = 0; k < neighs.size(); k++) {
+			uint id = neighs.first[k];
+			float new_cost = node.cost + weights[k];
+
+			if (!s.seen(id)) {
+				s.stamp[id] = s.generation;
+				s.heuristic[id] = get_dist(g->get_vertice(id),
+							   goal, q_size);
+			} else if (new_cost >= s.cost[id]) {
+				continue;
+			}
+
+			s.cost[id] = new_cost;
+			s.through[id] = node.idx;
+			s.open.push_back(
+			    {new_cost + s.heuristic[id], new_cost, id});
+			std::push_heap(s.open.begin(), s.open.end(),
+				       open_greater);
+		}
+	}
+
+	if (!found)
+		return {};
+
+	return s.trace(start, finish);
+}
+
+/*
+ * Every relaxation gets its own entry, as the cheapest one for a vertex may
+ * fail its check and leave the next one to settle it. Vertices are not
+ * expanded again, which keeps the factor bound of the weighted heuristic.
+ */
+std::vector<uint> lazy_astar_path(graph *g, uint start, uint finish,
+				  const edge_check &check, search_state *state,
+				  float heuristic_scale)
+{
+	search_state local_state;
+	search_state &s = state ? *state : local_state;
+	uint q_size = g->q_size;
+	float *goal = g->get_vertice(finish);
+	auto open_greater = [](const search_state::lazy_node &n1,
+			       const search_state::lazy_node &n2) {
+		return n1.est > n2.est;
+	};
+
+	s.begin(g->get_num_verts());
+	s.lazy_open.push_back({0.f, 0.f, start, start});
+
+	bool found = false;
+
+	while (!s.lazy_open.empty()) {
+		std::pop_heap(s.lazy_open.begin(), s.lazy_open.end(),
+			      open_greater);
+		search_state::lazy_node node = s.lazy_open.back();
+		s.lazy_open.pop_back();
+
+		if (s.closed[node.idx] == s.generation)
+			continue;
+		if (node.through != node.idx && !check(node.through, node.idx))
+			continue;
+
+		s.closed[node.idx] = s.generation;
+		s.cost[node.idx] = node.cost;
+		s.through[node.idx] = node.through;
+		if (node.idx == finish) {
+			found = true;
+			break;
+		}
+
+		s.num_expanded++;
+		/* check may have edited the graph, take the range afterwards */
+		neigh_range neighs = g->neighbours(node.idx);
+		const float *weights = g->neighbour_weights(node.idx);
+
+		for (uint k = 0; k < neighs.size(); k++) {
+			uint id = neighs.first[k];
+			float new_cost = node.cost + weights[k];
+
+			if (s.closed[id] == s.generation)
+				continue;
+			if (!s.seen(id)) {
+				s.stamp[id] = s.generation;
+				s.heuristic[id] =
+				    heuristic_scale *
+				    get_dist(g->get_vertice(id), goal, q_size);
+			}
+
+			float est = new_cost + s.heuristic[id];
+			s.lazy_open.push_back({est, new_cost, id, node.idx});
+			std::push_heap(s.lazy_open.begin(), s.lazy_open.end(),
+				       open_greater);
+		}
+	}
+
+	if (!found)
+		return {};
+
+	return s.trace(start, finish);
+}
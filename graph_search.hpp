@@ -0,0 +1,79 @@
+#ifndef GRAPH_SEARCH_H
+#define GRAPH_SEARCH_H
+
+#include <functional>
+#include <vector>
+
+typedef unsigned int uint;
+
+class graph;
+
+/* Whether the roadmap edge between two vertices can be used */
+typedef std::function<bool(uint from, uint to)> edge_check;
+
+/*
+ * Scratch memory for shortest path queries, kept between queries so they do
+ * not allocate. Entries are only valid when stamped with the current query's
+ * generation, so starting a new search does not touch the old marks.
+ */
+class search_state {
+      private:
+	struct open_node {
+		float est; /* cost so far plus heuristic */
+		float cost;
+		uint idx;
+	};
+	struct lazy_node {
+		float est;
+		float cost;
+		uint idx;
+		uint through; /* vertex the unchecked edge comes from */
+	};
+
+	uint generation = 0;
+	std::vector<uint> stamp;
+	std::vector<float> cost;
+	std::vector<float> heuristic;
+	std::vector<uint> through;
+	std::vector<open_node> open;
+	std::vector<uint> closed; /* generation once expanded, lazy search */
+	std::vector<lazy_node> lazy_open;
+
+	void begin(uint num_verts);
+	bool seen(uint idx) { return stamp[idx] == generation; }
+	std::vector<uint> trace(uint start, uint finish);
+
+	friend std::vector<uint> astar_path(graph *g, uint start, uint finish,
+					    search_state *state);
+	friend std::vector<uint>
+	lazy_astar_path(graph *g, uint start, uint finish,
+			const edge_check &check, search_state *state,
+			float heuristic_scale);
+
+      public:
+	uint num_expanded = 0; /* vertices expanded by the last query */
+	float path_cost = 0.f; /* length of the last path found */
+};
+
+/*
+ * Shortest path between two roadmap vertices by A* with the straight line
+ * distance as heuristic, over the edge lengths stored in the graph. Empty if
+ * finish can't be reached. Without a state a temporary one is used.
+ */
+std::vector<uint> astar_path(graph *g, uint start, uint finish,
+			     search_state *state = nullptr);
+
+/*
+ * Lazy weighted A*: an edge is only checked once the search is about to
+ * settle a vertex through it. A failed edge is skipped and the search goes on
+ * from the next best entry, so invalid edges cost no new search and every
+ * edge of the path returned passed check. With heuristic_scale above 1 the
+ * path may be up to that factor longer than the shortest valid one, in
+ * exchange for fewer expansions and so fewer checks.
+ */
+std::vector<uint> lazy_astar_path(graph *g, uint start, uint finish,
+				  const edge_check &check,
+				  search_state *state = nullptr,
+				  float heuristic_scale = 1.f);
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef HEADLESS_SHAPES_H
+#define HEADLESS_SHAPES_H
+
+/*
+ * The parts of gl_sdl_shape_obj.hpp the planners use, without SDL or OpenGL.
+ * Built with -DHEADLESS in place of the library, for runs on machines that
+ * have no display. Shapes keep their geometry and transforms, drawing and
+ * mouse handling do nothing.
+ */
+
+typedef unsigned int uint;
+
+struct point {
+	float x;
+	float y;
+};
+
+typedef point vect;
+
+struct circle {
+	point center;
+	float radius;
+};
+
+struct line {
+	point start;
+	point end;
+};
+
+struct tri {
+	point a;
+	point b;
+	point c;
+};
+
+struct rect {
+	float x;
+	float y;
+	float w;
+	float h;
+};
+
+struct color {
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+struct space_2d {
+	rect viewport;
+	float w;
+};
+
+enum { SDL_MOUSEMOTION = 1, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP };
+
+struct SDL_Event {
+	uint type;
+};
+
+extern color colors[18];
+
+bool intersect(circle *c, line *l);
+
+/* Only a translation, move() adds to it and apply_transform() bakes it in */
+class shape {
+      protected:
+	point offset = {0.f, 0.f};
+	virtual void bake(point delta) {}
+
+      public:
+	virtual ~shape() {}
+	virtual bool intersects_with(shape *other) { return false; }
+	void move(point delta)
+	{
+		offset.x += delta.x;
+		offset.y += delta.y;
+	}
+	void set_origin(point p) { offset = p; }
+	point get_offset() { return offset; }
+	void reset_transform() { offset = {0.f, 0.f}; }
+	void apply_transform()
+	{
+		bake(offset);
+		offset = {0.f, 0.f};
+	}
+	void set_fill_in(bool fill) {}
+	void set_draw_border(bool border) {}
+	void set_enabled(bool enabled) {}
+};
+
+class shape_circle : public shape {
+      private:
+	circle data;
+	circle placed()
+	{
+		return {{data.center.x + offset.x, data.center.y + offset.y},
+			data.radius};
+	}
+	virtual void bake(point delta) override
+	{
+		data.center.x += delta.x;
+		data.center.y += delta.y;
+	}
+	bool placed_intersects(circle *other);
+
+      public:
+	shape_circle() : data{{0.f, 0.f}, 1.f} {}
+	shape_circle(float radius) : data{{0.f, 0.f}, radius} {}
+	shape_circle(point center, float radius) : data{center, radius} {}
+	shape_circle(circle c) : data(c) {}
+	/* Without the pending transform, as in the library */
+	circle get_data() { return data; }
+	virtual bool intersects_with(shape *other) override;
+	bool intersects_another_circle(circle *other);
+	bool intersects_tri(tri *t);
+};
+
+template <class T> struct shape_manager_state {
+	uint num_shapes;
+	T *shapes;
+};
+
+template <class T> void assign_random_colors(shape_manager_state<T> *state) {}
+
+template <class T>
+bool try_drag_all_shapes(SDL_Event *event, shape_manager_state<T> *state,
+			 space_2d *space)
+{
+	return false;
+}
+
+template <class T> void draw_all_shapes(shape_manager_state<T> *state) {}
+
+void start_2d(space_2d *space);
+void use_rectangle(space_2d *space, rect *r, float w);
+void set_line_width(float width);
+void set_draw_color(color *c);
+void set_offset(point *p);
+void set_rot_angle(float angle);
+void draw_line(line *l);
+void draw_circle(circle *c);
+
+#endif
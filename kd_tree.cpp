@@ -0,0 +1,227 @@
+#include "kd_tree.hpp"
+#include <algorithm>
+
+static float dist_sq(const float *v1, const float *v2, uint size)
+{
+	float d_sq = 0.f;
+
+	for (uint j = 0; j < size; j++) {
+		float d = v1[j] - v2[j];
+		d_sq += d * d;
+	}
+
+	return d_sq;
+}
+
+static bool match_less(const kd_match &m1, const kd_match &m2)
+{
+	return m1.dist_sq < m2.dist_sq;
+}
+
+static uint floor_log2(uint val)
+{
+	uint lg = 0;
+	while (val >>= 1)
+		lg++;
+	return lg;
+}
+
+void kd_tree::clear()
+{
+	nodes.clear();
+	root = NONE;
+}
+
+void kd_tree::insert(const float *points, uint idx)
+{
+	const float *p = points + idx * dim;
+	kd_node new_node = {idx, NONE, NONE, 0};
+
+	if (root == NONE) {
+		root = nodes.size();
+		nodes.push_back(new_node);
+		return;
+	}
+
+	uint cur = root;
+	uint depth = 1;
+
+	while (true) {
+		kd_node &node = nodes[cur];
+		const float *node_p = points + node.idx * dim;
+		uint &next = p[node.split] < node_p[node.split] ? node.left
+								 : node.right;
+		depth++;
+
+		if (next == NONE) {
+			new_node.split = (node.split + 1) % dim;
+			next = nodes.size();
+			nodes.push_back(new_node);
+			break;
+		}
+
+		cur = next;
+	}
+
+	/* Unlucky insertion order, restore logarithmic depth */
+	if (depth > 3 * floor_log2(nodes.size()) + 16)
+		rebuild(points);
+}
+
+uint kd_tree::build_range(const float *points, uint *ids, uint count)
+{
+	if (!count)
+		return NONE;
+
+	uint split = 0;
+	float best_spread = -1.f;
+
+	for (uint d = 0; d < dim; d++) {
+		float low = points[ids[0] * dim + d];
+		float high = low;
+
+		for (uint i = 1; i < count; i++) {
+			float val = points[ids[i] * dim + d];
+			low = std::min(low, val);
+			high = std::max(high, val);
+		}
+
+		if (high - low > best_spread) {
+			best_spread = high - low;
+			split = d;
+		}
+	}
+
+	uint mid = count / 2;
+	std::nth_element(ids, ids + mid, ids + count, [&](uint a, uint b) {
+		return points[a * dim + split] < points[b * dim + split];
+	});
+
+	uint node_id = nodes.size();
+	nodes.push_back({ids[mid], NONE, NONE, split});
+
+	uint left = build_range(points, ids, mid);
+	uint right = build_range(points, ids + mid + 1, count - mid - 1);
+	nodes[node_id].left = left;
+	nodes[node_id].right = right;
+
+	return node_id;
+}
+
+void kd_tree::rebuild(const float *points)
+{
+	std::vector<uint> ids;
+	ids.reserve(nodes.size());
+	for (auto &node : nodes)
+		ids.push_back(node.idx);
+
+	clear();
+	nodes.reserve(ids.size());
+	root = build_range(points, ids.data(), ids.size());
+}
+
+void kd_tree::radius_rec(const float *points, uint node_id, const float *ref,
+			 float r_sq, std::vector<kd_match> &out) const
+{
+	while (node_id != NONE) {
+		const kd_node &node = nodes[node_id];
+		const float *p = points + node.idx * dim;
+		float d_sq = dist_sq(p, ref, dim);
+
+		if (d_sq <= r_sq)
+			out.push_back({node.idx, d_sq});
+
+		float diff = ref[node.split] - p[node.split];
+		uint near = diff < 0.f ? node.left : node.right;
+		uint far = diff < 0.f ? node.right : node.left;
+
+		if (diff * diff <= r_sq)
+			radius_rec(points, far, ref, r_sq, out);
+		node_id = near;
+	}
+}
+
+void kd_tree::radius_search(const float *points, const float *ref, float r_sq,
+			    std::vector<kd_match> &out) const
+{
+	out.clear();
+	radius_rec(points, root, ref, r_sq, out);
+}
+
+void kd_tree::knn_rec(const float *points, uint node_id, const float *ref,
+		      uint k, float *worst, std::vector<kd_match> &heap) const
+{
+	if (node_id == NONE)
+		return;
+
+	const kd_node &node = nodes[node_id];
+	const float *p = points + node.idx * dim;
+	float d_sq = dist_sq(p, ref, dim);
+
+	if (d_sq <= *worst) {
+		if (heap.size() == k) {
+			std::pop_heap(heap.begin(), heap.end(), match_less);
+			heap.pop_back();
+		}
+
+		heap.push_back({node.idx, d_sq});
+		std::push_heap(heap.begin(), heap.end(), match_less);
+
+		if (heap.size() == k)
+			*worst = heap.front().dist_sq;
+	}
+
+	float diff = ref[node.split] - p[node.split];
+	uint near = diff < 0.f ? node.left : node.right;
+	uint far = diff < 0.f ? node.right : node.left;
+
+	knn_rec(points, near, ref, k, worst, heap);
+	if (diff * diff <= *worst)
+		knn_rec(points, far, ref, k, worst, heap);
+}
+
+void kd_tree::knn_search(const float *points, const float *ref, uint k,
+			 std::vector<kd_match> &out, float max_r_sq) const
+{
+	out.clear();
+	if (!k)
+		return;
+
+	float worst = max_r_sq;
+	knn_rec(points, root, ref, k, &worst, out);
+	std::sort_heap(out.begin(), out.end(), match_less);
+}
+
+uint kd_tree::nearest(const float *points, const float *ref) const
+{
+	uint best = NONE;
+	float best_sq = std::numeric_limits<float>::max();
+	uint stack[128];
+	uint top = 0;
+
+	if (root != NONE)
+		stack[top++] = root;
+
+	/* Depth is bounded by insert(), so a small fixed stack is enough */
+	while (top) {
+		const kd_node &node = nodes[stack[--top]];
+		const float *p = points + node.idx * dim;
+		float d_sq = dist_sq(p, ref, dim);
+
+		if (d_sq < best_sq) {
+			best_sq = d_sq;
+			best = node.idx;
+		}
+
+		float diff = ref[node.split] - p[node.split];
+		uint near = diff < 0.f ? node.left : node.right;
+		uint far = diff < 0.f ? node.right : node.left;
+
+		if (far != NONE && diff * diff < best_sq)
+			stack[top++] = far;
+		if (near != NONE)
+			stack[top++] = near;
+	}
+
+	return best;
+}
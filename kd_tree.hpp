@@ -0,0 +1,59 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include <limits>
+#include <vector>
+
+typedef unsigned int uint;
+
+struct kd_match {
+	uint idx;
+	float dist_sq;
+};
+
+/*
+ * k-d tree over points stored elsewhere (q_size floats per point, indexed by
+ * point id). Points are passed into every call, so the owner is free to
+ * reallocate its storage. Nodes hold one point each, which keeps insertion of
+ * single points cheap; rebuild() restores balance after bulk insertion.
+ */
+class kd_tree {
+      private:
+	struct kd_node {
+		uint idx;
+		uint left;
+		uint right;
+		uint split;
+	};
+
+	uint dim;
+	uint root = NONE;
+	std::vector<kd_node> nodes;
+
+	uint build_range(const float *points, uint *ids, uint count);
+	void radius_rec(const float *points, uint node, const float *ref,
+			float r_sq, std::vector<kd_match> &out) const;
+	void knn_rec(const float *points, uint node, const float *ref, uint k,
+		     float *worst, std::vector<kd_match> &heap) const;
+
+      public:
+	static const uint NONE = std::numeric_limits<uint>::max();
+	static constexpr float NO_LIMIT = std::numeric_limits<float>::max();
+
+	kd_tree(uint dim) : dim(dim) {}
+	void clear();
+	uint size() const { return nodes.size(); }
+	void insert(const float *points, uint idx);
+	void rebuild(const float *points);
+
+	/* All points with squared distance to ref <= r_sq, in no order */
+	void radius_search(const float *points, const float *ref, float r_sq,
+			   std::vector<kd_match> &out) const;
+	/* Up to k closest points within max_r_sq, sorted by distance */
+	void knn_search(const float *points, const float *ref, uint k,
+			std::vector<kd_match> &out,
+			float max_r_sq = NO_LIMIT) const;
+	uint nearest(const float *points, const float *ref) const;
+};
+
+#endif
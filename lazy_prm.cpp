@@ -0,0 +1,87 @@
+#include "lazy_prm.hpp"
+#include <chrono>
+
+static uint64_t edge_key(uint id1, uint id2)
+{
+	if (id1 > id2)
+		std::swap(id1, id2);
+	return ((uint64_t)id1 << 32) | id2;
+}
+
+graph *lazy_prm::init_algo_internal(system_nd *new_sys)
+{
+	valid_edges.clear();
+	edges_checked = 0;
+	return prm::init_algo_internal(new_sys);
+}
+
+std::vector<float> lazy_prm::find_path(graph *cur_set, system_nd *sys,
+				       float *start, float *finish)
+{
+	phase_timer timer(PHASE_QUERY);
+	float con_r_sq = get_connection_radius(sys);
+	bool exact_components = false;
+	attach_cache ends;
+	uint start_neigh;
+	uint end_neigh;
+
+	auto check = [&](uint id1, uint id2) {
+		uint64_t key = edge_key(id1, id2);
+
+		if (valid_edges.count(key))
+			return true;
+
+		edges_checked++;
+		if (sys->valid_cfg_seq(cur_set->get_vertice(id1),
+				       cur_set->get_vertice(id2))) {
+			valid_edges.insert(key);
+			return true;
+		}
+
+		cur_set->remove_edge(id1, id2);
+		exact_components = false;
+		return false;
+	};
+
+	while (attach_path_ends(cur_set, sys, start, finish, con_r_sq,
+				&start_neigh, &end_neigh, &ends)) {
+		auto id_path = lazy_astar_path(cur_set, start_neigh, end_neigh,
+					       check, &search, search_weight);
+		if (!id_path.empty())
+			return path_from_ids(cur_set, id_path, start, finish);
+
+		/* Removed edges may have split components, recount once */
+		if (exact_components)
+			break;
+		cur_set->rebuild_components();
+		exact_components = true;
+	}
+
+	return {};
+}
+
+std::vector<query_result> lazy_prm::find_paths(graph *cur_set, system_nd *sys,
+					       const float *starts,
+					       const float *finishes,
+					       uint count)
+{
+	std::vector<query_result> results(count);
+	uint q_size = cur_set->q_size;
+
+	for (uint i = 0; i < count; i++) {
+		auto t0 = std::chrono::steady_clock::now();
+		std::vector<float> start(starts + i * q_size,
+					 starts + (i + 1) * q_size);
+		std::vector<float> finish(finishes + i * q_size,
+					  finishes + (i + 1) * q_size);
+
+		results[i].path =
+		    find_path(cur_set, sys, start.data(), finish.data());
+
+		auto t1 = std::chrono::steady_clock::now();
+		results[i].time_ms =
+		    std::chrono::duration<double, std::milli>(t1 - t0).count();
+	}
+
+	return results;
+}
@@ -0,0 +1,36 @@
+#ifndef LAZY_PRM_H
+#define LAZY_PRM_H
+#include "prm.hpp"
+#include <unordered_set>
+
+/*
+ * Lazy PRM: roadmap edges are added without collision checks. An edge in the
+ * graph is unknown until the search of a path query reaches it, invalid edges
+ * are removed from the graph as the search finds them, see lazy_astar_path.
+ */
+class lazy_prm : public prm {
+      protected:
+	std::unordered_set<uint64_t> valid_edges;
+	virtual bool check_connection() override { return false; }
+	virtual bool check_edge(float *v1, float *v2) override { return true; }
+	virtual graph *init_algo_internal(system_nd *new_sys) override;
+
+      public:
+	uint edges_checked = 0;
+	/* Paths up to this factor longer than the shortest, for fewer checks */
+	float search_weight = 2.f;
+	virtual std::vector<float> find_path(graph *cur_set, system_nd *sys,
+					     float *start,
+					     float *finish) override;
+	/* Queries edit the graph, so these run one after another */
+	virtual std::vector<query_result>
+	find_paths(graph *cur_set, system_nd *sys, const float *starts,
+		   const float *finishes, uint count) override;
+	lazy_prm(uint num_points, float r_multi) : prm(num_points, r_multi) {}
+	lazy_prm(uint num_points, float r_multi, sampler *generator)
+	    : prm(num_points, r_multi, generator)
+	{
+	}
+};
+
+#endif
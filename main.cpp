@@ -1,6 +1,10 @@
 #include "algorithm.hpp"
 #include "interface.hpp"
+#include "lazy_prm.hpp"
+#include "path_shortcut.hpp"
 #include "prm.hpp"
+#include "rrt.hpp"
+#include "samplers.hpp"
 #include "shape_collections.hpp"
 #include <ImGuiFileDialog.h>
 #include <gl_sdl_2d.hpp>
@@ -30,6 +34,17 @@ static int num_prm_nodes = 50;
 static int num_proceed = 1;
 static float r_multi = 0.1f;
 static int algo_type = 0;
+static int algo_seed = 0;
+static int num_threads = 0;
+static int edge_batch = 0;
+static int num_grow = 100;
+static bool use_cspace_grid = false;
+static bool use_edge_cache = false;
+static int sampler_type = 0;
+static int strategy_type = 0;
+static int shortcut_checks = 500;
+static float shortcut_time = 0.f;
+static shortcut_stats last_shortcut;
 
 /* Temporary variables */
 float cur_pos[] = {0.f, 0.f};
@@ -69,7 +84,11 @@ int display()
 	return 0;
 }
 
-static void delete_path() { path.clear(); }
+static void delete_path()
+{
+	path.clear();
+	last_shortcut = {};
+}
 
 static void reset_graph(graph *roadmap)
 {
@@ -105,8 +124,32 @@ static void path_gui()
 	    algo.get()) {
 		float *start = problem->get_start();
 		float *finish = problem->get_finish();
-		path = build_path(cur_graph.get(), problem.get(), start, finish,
-				  algo->get_connection_radius(problem.get()));
+		path = algo->find_path(cur_graph.get(), problem.get(), start,
+				       finish);
+		last_shortcut = {};
+	}
+
+	if (path.size()) {
+		ImGui::DragInt("Shortcut checks", &shortcut_checks, 10, 0,
+			       100000);
+		ImGui::DragFloat("Shortcut time ms", &shortcut_time, 1.f, 0.f,
+				 10000.f);
+		if (ImGui::Button("Shortcut path")) {
+			shortcut_params params;
+			params.max_checks = shortcut_checks;
+			params.max_time_ms = shortcut_time;
+			params.seed = algo_seed;
+			last_shortcut =
+			    shortcut_path(path, problem.get(), params);
+		}
+		if (last_shortcut.length_before > 0.f)
+			ImGui::Text("Length %.1f -> %.1f (-%.1f%%), %u checks, "
+				    "%.2f ms",
+				    last_shortcut.length_before,
+				    last_shortcut.length_after,
+				    100.f * last_shortcut.reduction(),
+				    last_shortcut.checks,
+				    last_shortcut.time_ms);
 	}
 
 	animation_gui();
@@ -117,8 +160,51 @@ static void path_gui()
 
 static algorithm *algo_from_enum(int enum_val)
 {
-	return enum_val ? new s_prm(num_prm_nodes, r_multi)
-			: new prm(num_prm_nodes, r_multi);
+	prm *new_algo;
+
+	switch (enum_val) {
+	case 4:
+		return new rrt_connect(num_prm_nodes, r_multi);
+	case 1:
+		new_algo = new s_prm(num_prm_nodes, r_multi);
+		break;
+	case 2:
+		new_algo = new k_prm(num_prm_nodes);
+		break;
+	case 3:
+		new_algo = new lazy_prm(num_prm_nodes, r_multi);
+		break;
+	default:
+		new_algo = new prm(num_prm_nodes, r_multi);
+		break;
+	}
+
+	new_algo->batch_size = edge_batch;
+	return new_algo;
+}
+
+static sampler *sampler_from_enum(int enum_val)
+{
+	switch (enum_val) {
+	case 1:
+		return new halton_sampler;
+	case 2:
+		return new sobol_sampler;
+	default:
+		return new sampler_imp<std::mt19937>;
+	}
+}
+
+static sampling_strategy *strategy_from_enum(int enum_val)
+{
+	switch (enum_val) {
+	case 1:
+		return new gaussian_strategy;
+	case 2:
+		return new bridge_strategy;
+	default:
+		return new uniform_strategy;
+	}
 }
 
 static void reset_viewport_to_window(SDL_Window *window)
@@ -311,12 +397,38 @@ int main(int, char **)
 		ImGui::DragFloat("Connection radius multi", &r_multi, 0.01f,
 				 0.01f, 1.f);
 
+		ImGui::DragInt("Seed", &algo_seed, 0.5f, 0, 100000);
+		ImGui::DragInt("Threads (0 = all)", &num_threads, 0.1f, 0, 64);
+		ImGui::DragInt("Edge batch (0 = serial)", &edge_batch, 1.f, 0,
+			       5000);
+
+		ImGui::Checkbox("C-space grid (up to 3 dims)",
+				&use_cspace_grid);
+		ImGui::Checkbox("Cache edge checks", &use_edge_cache);
+
+		ImGui::RadioButton("Random", &sampler_type, 0);
+		ImGui::RadioButton("Halton", &sampler_type, 1);
+		ImGui::RadioButton("Sobol", &sampler_type, 2);
+
+		ImGui::RadioButton("Uniform", &strategy_type, 0);
+		ImGui::RadioButton("Gaussian", &strategy_type, 1);
+		ImGui::RadioButton("Bridge test", &strategy_type, 2);
+
 		ImGui::RadioButton("PRM", &algo_type, 0);
 		ImGui::RadioButton("sPRM", &algo_type, 1);
+		ImGui::RadioButton("kPRM*", &algo_type, 2);
+		ImGui::RadioButton("Lazy PRM", &algo_type, 3);
+		ImGui::RadioButton("RRT-Connect", &algo_type, 4);
 
 		if (ImGui::Button("Start building")) {
 
 			algo.reset(algo_from_enum(algo_type));
+			algo->set_sampler(sampler_from_enum(sampler_type));
+			algo->set_strategy(strategy_from_enum(strategy_type));
+			algo->set_seed(algo_seed);
+			algo->set_num_threads(num_threads);
+			algo->set_cspace_grid(use_cspace_grid);
+			algo->set_edge_cache(use_edge_cache);
 			reset_graph(algo->init_algo(problem.get()));
 			graph_msg = "Keep going";
 		}
@@ -329,11 +441,53 @@ int main(int, char **)
 			       algo->continue_map(cur_graph.get()))
 				graph_msg = "Keep going";
 
-			if (updates_left)
+			if (updates_left) {
 				graph_msg = "Algo finished";
+				cur_graph->freeze();
+			}
+		}
+
+		/* RRT-Connect stops at its first path, nothing to grow */
+		bool can_grow =
+		    cur_graph.get() && algo.get() && algo->can_grow();
+		if (can_grow)
+			ImGui::DragInt("Grow by", &num_grow, 0.5f, 1, 5000);
+		if (can_grow && ImGui::Button("Grow roadmap")) {
+			if (algo->grow_map(cur_graph.get(), num_grow)) {
+				graph_msg = "Keep going";
+				delete_path();
+			}
+			else {
+				graph_msg = "Finish building before growing";
+			}
 		}
 
 		ImGui::Text("%s", graph_msg.c_str());
+		if (cur_graph.get())
+			ImGui::Text("Components: %u",
+				    cur_graph->get_num_components());
+		if (algo.get()) {
+			sampling_stats stats = algo->get_sampling_stats();
+			ImGui::Text("valid_cfg calls per sample: %.2f",
+				    stats.calls_per_sample());
+			if (stats.fallbacks)
+				ImGui::Text(
+				    "%llu uniform fallback samples",
+				    (unsigned long long)stats.fallbacks);
+		}
+		if (problem->get_occupancy()) {
+			const cspace_grid *grid = problem->get_occupancy();
+			ImGui::Text("C-space grid: %.1f%% free, %.1f%% blocked",
+				    100.f * grid->free_fraction(),
+				    100.f * grid->blocked_fraction());
+		}
+		if (algo.get() && problem->get_edge_cache()) {
+			cache_stats cache = algo->get_edge_cache_stats();
+			ImGui::Text("Edge cache: %.1f%% of %llu hit",
+				    100.f * cache.hit_rate(),
+				    (unsigned long long)(cache.hits +
+							 cache.misses));
+		}
 
 		if (ImGui::Button("Clear graph"))
 			reset_graph(NULL);
@@ -343,6 +497,7 @@ int main(int, char **)
 		ImGui::End();
 
 		show_private_params(problem.get());
+		show_planner_stats();
 
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -0,0 +1,77 @@
+#include "obstacle_grid.hpp"
+
+/* Cells per circle in cells, balances cell scans against circle tests */
+#define GRID_FILL 2.f
+
+void obstacle_grid::rebuild(const std::vector<circle> &new_circles)
+{
+	circles = new_circles;
+	cell_offsets.clear();
+	cell_ids.clear();
+	slots.clear();
+	large_begin = 0;
+	num_x = num_y = 0;
+	max_r = 0.f;
+
+	uint n = circles.size();
+	if (!n)
+		return;
+
+	float x_low = circles[0].center.x;
+	float x_high = x_low;
+	float y_low = circles[0].center.y;
+	float y_high = y_low;
+	std::vector<float> radii(n);
+
+	for (uint i = 0; i < n; i++) {
+		x_low = std::min(x_low, circles[i].center.x);
+		x_high = std::max(x_high, circles[i].center.x);
+		y_low = std::min(y_low, circles[i].center.y);
+		y_high = std::max(y_high, circles[i].center.y);
+		radii[i] = circles[i].radius;
+	}
+
+	/* Cells about the size of a typical circle, or of its share of area */
+	std::nth_element(radii.begin(), radii.begin() + n / 2, radii.end());
+	float area = std::max(x_high - x_low, 1.f) *
+		     std::max(y_high - y_low, 1.f);
+	cell = std::max(2.f * radii[n / 2], sqrtf(area * GRID_FILL / n));
+	cell = std::max(cell, 1e-3f);
+	inv_cell = 1.f / cell;
+	origin = {x_low, y_low};
+	num_x = (int)((x_high - x_low) * inv_cell) + 1;
+	num_y = (int)((y_high - y_low) * inv_cell) + 1;
+
+	uint num_cells = num_x * num_y;
+	std::vector<uint> cell_of(n);
+	cell_offsets.assign(num_cells + 1, 0);
+
+	for (uint i = 0; i < n; i++) {
+		if (circles[i].radius > cell) {
+			cell_of[i] = num_cells;
+			continue;
+		}
+
+		max_r = std::max(max_r, circles[i].radius);
+		cell_of[i] = cell_y(circles[i].center.y) * num_x +
+			     cell_x(circles[i].center.x);
+		cell_offsets[cell_of[i] + 1]++;
+	}
+
+	for (uint i = 0; i < num_cells; i++)
+		cell_offsets[i + 1] += cell_offsets[i];
+
+	std::vector<uint> fill(cell_offsets.begin(), cell_offsets.end() - 1);
+	large_begin = cell_offsets.back();
+	cell_ids.resize(large_begin);
+	for (uint i = 0; i < n; i++) {
+		if (cell_of[i] < num_cells)
+			cell_ids[fill[cell_of[i]]++] = i;
+		else
+			cell_ids.push_back(i);
+	}
+
+	for (uint id : cell_ids)
+		slots.push(circles[id].center.x, circles[id].center.y,
+			   circles[id].radius);
+}
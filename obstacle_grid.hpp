@@ -0,0 +1,130 @@
+#ifndef OBSTACLE_GRID_H
+#define OBSTACLE_GRID_H
+
+#include "segment_kernel.hpp"
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#ifdef HEADLESS
+#include "headless_shapes.hpp"
+#else
+#include <gl_sdl_shape_obj.hpp>
+#endif
+
+typedef unsigned int uint;
+
+/*
+ * Uniform grid over obstacle circles for broad-phase queries. Every circle is
+ * stored once, in the cell holding its center, and queries are widened by
+ * the largest radius of those circles, so no circle is reported twice.
+ * Circles much bigger than a cell are kept aside and reported for every
+ * query. Queries only read the grid and can run from several threads.
+ *
+ * Circles are also laid out cell by cell in a structure of arrays, so the
+ * cells of one row form a single run that kernels can scan.
+ */
+class obstacle_grid {
+      private:
+	std::vector<circle> circles;
+	std::vector<uint> cell_offsets; /* cell i is slots [off[i], off[i+1]) */
+	std::vector<uint> cell_ids;	/* circle id of each slot */
+	circle_soa slots;		/* large circles after the cells */
+	uint large_begin = 0;
+	point origin = {0.f, 0.f};
+	float cell = 1.f;
+	float inv_cell = 1.f;
+	float max_r = 0.f; /* of the circles in cells */
+	int num_x = 0;
+	int num_y = 0;
+
+	int cell_x(float x) const
+	{
+		return std::min(num_x - 1,
+				std::max(0, (int)floorf((x - origin.x) *
+							inv_cell)));
+	}
+	int cell_y(float y) const
+	{
+		return std::min(num_y - 1,
+				std::max(0, (int)floorf((y - origin.y) *
+							inv_cell)));
+	}
+
+      public:
+	void rebuild(const std::vector<circle> &new_circles);
+	uint size() const { return circles.size(); }
+	const circle &get(uint idx) const { return circles[idx]; }
+	const std::vector<circle> &get_all() const { return circles; }
+
+	const circle_soa &get_slots() const { return slots; }
+	uint get_slot_id(uint slot) const { return cell_ids[slot]; }
+
+	/*
+	 * Calls hit_run(begin, end) for runs of slots holding every circle
+	 * that may come within r of the segment p1-p2, stops and returns true
+	 * as soon as hit_run does.
+	 */
+	template <class F>
+	bool any_run_near_segment(point p1, point p2, float r, F hit_run) const
+	{
+		if (large_begin < slots.size() &&
+		    hit_run(large_begin, slots.size()))
+			return true;
+		if (!num_x)
+			return false;
+
+		float reach = r + max_r;
+		float dy = p2.y - p1.y;
+		int y_low = cell_y(std::min(p1.y, p2.y) - reach);
+		int y_high = cell_y(std::max(p1.y, p2.y) + reach);
+
+		for (int y = y_low; y <= y_high; y++) {
+			/* Part of the segment within reach of this row */
+			float row_low = origin.y + y * cell - reach;
+			float row_high = row_low + cell + 2.f * reach;
+			float t0 = 0.f;
+			float t1 = 1.f;
+
+			if (dy != 0.f) {
+				float ta = (row_low - p1.y) / dy;
+				float tb = (row_high - p1.y) / dy;
+				t0 = std::max(t0, std::min(ta, tb));
+				t1 = std::min(t1, std::max(ta, tb));
+				if (t0 > t1)
+					continue;
+			}
+
+			float xa = p1.x + t0 * (p2.x - p1.x);
+			float xb = p1.x + t1 * (p2.x - p1.x);
+			int x_low = cell_x(std::min(xa, xb) - reach);
+			int x_high = cell_x(std::max(xa, xb) + reach);
+			uint begin = cell_offsets[y * num_x + x_low];
+			uint end = cell_offsets[y * num_x + x_high + 1];
+
+			if (begin < end && hit_run(begin, end))
+				return true;
+		}
+
+		return false;
+	}
+
+	/* As above, calling hit(idx) with the id of every such circle */
+	template <class F>
+	bool any_near_segment(point p1, point p2, float r, F hit) const
+	{
+		return any_run_near_segment(p1, p2, r, [&](uint b, uint e) {
+			for (uint k = b; k < e; k++)
+				if (hit(cell_ids[k]))
+					return true;
+			return false;
+		});
+	}
+
+	template <class F> bool any_near_disc(circle c, F hit) const
+	{
+		return any_near_segment(c.center, c.center, c.radius, hit);
+	}
+};
+
+#endif
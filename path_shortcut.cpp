@@ -0,0 +1,235 @@
+#include "path_shortcut.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+static float get_dist(const float *v1, const float *v2, uint size)
+{
+	float dist_sq = 0.f;
+
+	for (uint j = 0; j < size; j++)
+		dist_sq += (v1[j] - v2[j]) * (v1[j] - v2[j]);
+
+	return sqrtf(dist_sq);
+}
+
+float path_length(std::vector<float> &path, uint q_size)
+{
+	float length = 0.f;
+
+	for (uint i = q_size; i < path.size(); i += q_size)
+		length += get_dist(&path[i - q_size], &path[i], q_size);
+
+	return length;
+}
+
+/* Point at arc length pos, on the segment starting at vertex *seg */
+static void point_at(std::vector<float> &path, std::vector<float> &arc,
+		     uint q_size, float pos, uint *seg, float *dest)
+{
+	uint i = std::upper_bound(arc.begin(), arc.end(), pos) - arc.begin();
+	i = std::min<uint>(std::max<uint>(i, 1), arc.size() - 1) - 1;
+
+	float len = arc[i + 1] - arc[i];
+	float t = len > 0.f ? (pos - arc[i]) / len : 0.f;
+	float *p1 = &path[i * q_size];
+	float *p2 = &path[(i + 1) * q_size];
+
+	for (uint j = 0; j < q_size; j++)
+		dest[j] = p1[j] + t * (p2[j] - p1[j]);
+	*seg = i;
+}
+
+class shortcutter {
+      private:
+	std::vector<float> &path;
+	system_nd *sys;
+	const shortcut_params &params;
+	uint q_size;
+	std::chrono::steady_clock::time_point start_time;
+	std::mt19937 generator;
+	std::vector<float> arc;
+	std::vector<float> mid; /* replacement for the middle part */
+	std::vector<float> a_data; /* ends of the replaced part */
+	std::vector<float> b_data;
+	float *a;
+	float *b;
+
+	bool segment_valid(float *v1, float *v2)
+	{
+		/* Coinciding points would divide by zero in some systems */
+		if (get_dist(v1, v2, q_size) <= 0.f)
+			return true;
+		if (params.max_checks && stats.checks >= params.max_checks)
+			return false;
+		stats.checks++;
+		return sys->valid_cfg_seq(v1, v2);
+	}
+
+	void update_arc()
+	{
+		uint n = path.size() / q_size;
+
+		arc.resize(n);
+		arc[0] = 0.f;
+		for (uint i = 1; i < n; i++)
+			arc[i] = arc[i - 1] + get_dist(&path[(i - 1) * q_size],
+						       &path[i * q_size],
+						       q_size);
+	}
+
+	/* Replaces vertices (seg_a, seg_b] by a, mid and b */
+	void splice(uint seg_a, uint seg_b)
+	{
+		auto cut_a = path.begin() + (seg_a + 1) * q_size;
+		auto cut_b = path.begin() + (seg_b + 1) * q_size;
+		std::vector<float> new_path(path.begin(), cut_a);
+
+		new_path.insert(new_path.end(), a, a + q_size);
+		new_path.insert(new_path.end(), mid.begin(), mid.end());
+		new_path.insert(new_path.end(), b, b + q_size);
+		new_path.insert(new_path.end(), cut_b, path.end());
+		path.swap(new_path);
+		update_arc();
+	}
+
+	bool try_full(uint seg_a, uint seg_b, float old_len);
+	bool try_partial(uint seg_a, uint seg_b, float pos_a, float pos_b);
+
+      public:
+	shortcut_stats stats;
+
+	shortcutter(std::vector<float> &path, system_nd *sys,
+		    const shortcut_params &params)
+	    : path(path), sys(sys), params(params),
+	      q_size(sys->get_q_size()),
+	      start_time(std::chrono::steady_clock::now()),
+	      generator(params.seed), a_data(q_size), b_data(q_size),
+	      a(a_data.data()), b(b_data.data())
+	{
+		update_arc();
+	}
+
+	double elapsed_ms()
+	{
+		auto now = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(now -
+								 start_time)
+		    .count();
+	}
+
+	bool in_budget()
+	{
+		if (params.max_checks && stats.checks >= params.max_checks)
+			return false;
+		return !params.max_time_ms || elapsed_ms() < params.max_time_ms;
+	}
+
+	bool attempt();
+};
+
+bool shortcutter::try_full(uint seg_a, uint seg_b, float old_len)
+{
+	if (get_dist(a, b, q_size) >= old_len * 0.999f)
+		return false;
+	if (!segment_valid(a, b))
+		return false;
+
+	mid.clear();
+	splice(seg_a, seg_b);
+	stats.shortcuts++;
+	return true;
+}
+
+/*
+ * Joint d moves linearly from a to b over the vertices in between, placed by
+ * their arc length, while the other joints follow the old path.
+ */
+bool shortcutter::try_partial(uint seg_a, uint seg_b, float pos_a,
+			      float pos_b)
+{
+	uint d = std::uniform_int_distribution<uint>(0, q_size - 1)(generator);
+	float span = pos_b - pos_a;
+
+	mid.assign(path.begin() + (seg_a + 1) * q_size,
+		   path.begin() + (seg_b + 1) * q_size);
+	for (uint k = 0; k < mid.size(); k += q_size) {
+		float s = (arc[seg_a + 1 + k / q_size] - pos_a) / span;
+		mid[k + d] = a[d] + s * (b[d] - a[d]);
+	}
+
+	float new_len = 0.f;
+	float *prev = a;
+	for (uint k = 0; k < mid.size(); k += q_size) {
+		new_len += get_dist(prev, &mid[k], q_size);
+		prev = &mid[k];
+	}
+	new_len += get_dist(prev, b, q_size);
+
+	if (new_len >= span * 0.999f)
+		return false;
+
+	prev = a;
+	for (uint k = 0; k < mid.size(); k += q_size) {
+		if (!segment_valid(prev, &mid[k]))
+			return false;
+		prev = &mid[k];
+	}
+	if (!segment_valid(prev, b))
+		return false;
+
+	splice(seg_a, seg_b);
+	stats.partial++;
+	return true;
+}
+
+bool shortcutter::attempt()
+{
+	float total = arc.back();
+	std::uniform_real_distribution<float> along(0.f, total);
+	float pos_a = along(generator);
+	float pos_b = along(generator);
+	uint seg_a;
+	uint seg_b;
+
+	if (pos_a > pos_b)
+		std::swap(pos_a, pos_b);
+
+	point_at(path, arc, q_size, pos_a, &seg_a, a);
+	point_at(path, arc, q_size, pos_b, &seg_b, b);
+
+	/* Nothing to gain inside a single segment */
+	if (seg_a == seg_b)
+		return false;
+
+	if (std::bernoulli_distribution(0.5)(generator) && q_size > 1)
+		return try_partial(seg_a, seg_b, pos_a, pos_b);
+	return try_full(seg_a, seg_b, pos_b - pos_a);
+}
+
+shortcut_stats shortcut_path(std::vector<float> &path, system_nd *sys,
+			     const shortcut_params &params)
+{
+	uint q_size = sys->get_q_size();
+	float length_before = path_length(path, q_size);
+
+	if (path.size() < 3 * q_size) {
+		shortcut_stats stats;
+		stats.length_before = stats.length_after = length_before;
+		return stats;
+	}
+
+	shortcutter opt(path, sys, params);
+	uint fails = 0;
+	uint attempts = 0;
+
+	while (opt.in_budget() && attempts++ < MAX_SHORTCUT_ATTEMPTS &&
+	       (!params.max_fails || fails < params.max_fails))
+		fails = opt.attempt() ? 0 : fails + 1;
+
+	opt.stats.length_before = length_before;
+	opt.stats.length_after = path_length(path, q_size);
+	opt.stats.time_ms = opt.elapsed_ms();
+
+	return opt.stats;
+}
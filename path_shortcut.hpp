@@ -0,0 +1,45 @@
+#ifndef PATH_SHORTCUT_H
+#define PATH_SHORTCUT_H
+
+#include "shape_collections.hpp"
+
+/*
+ * Zero means no limit, the optimizer stops at whichever is hit first. With
+ * all of them zero it still stops after MAX_SHORTCUT_ATTEMPTS attempts.
+ */
+#define MAX_SHORTCUT_ATTEMPTS 100000
+
+struct shortcut_params {
+	uint max_checks = 500; /* valid_cfg_seq calls */
+	float max_time_ms = 0.f;
+	uint max_fails = 200; /* attempts in a row that changed nothing */
+	uint seed = 0;
+};
+
+struct shortcut_stats {
+	float length_before = 0.f;
+	float length_after = 0.f;
+	uint checks = 0;
+	uint shortcuts = 0; /* accepted straight line shortcuts */
+	uint partial = 0;   /* accepted single joint shortcuts */
+	double time_ms = 0.;
+
+	float reduction()
+	{
+		return length_before > 0.f ? 1.f - length_after / length_before
+					   : 0.f;
+	}
+};
+
+float path_length(std::vector<float> &path, uint q_size);
+
+/*
+ * Shortens a path in place by replacing the part between two random points
+ * along it with a straight line, or by interpolating only one joint between
+ * them and keeping the other coordinates. Changes are checked with
+ * valid_cfg_seq and only kept if valid and shorter.
+ */
+shortcut_stats shortcut_path(std::vector<float> &path, system_nd *sys,
+			     const shortcut_params &params);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Builds a roadmap for a saved scene and queries it, without SDL or OpenGL:
+ * make planner_bench && ./planner_bench scene.data [algo] [n] [r_multi]
+ *	[seed] [threads] [stats.json|stats.csv]
+ * algo is one of prm, sprm, kprm, lazy or rrt. Phase times and check
+ * latencies are printed, and saved if a file is given, when built with
+ * planner stats.
+ */
+#include "algorithm.hpp"
+#include "lazy_prm.hpp"
+#include "prm.hpp"
+#include "rrt.hpp"
+#include "shape_collections.hpp"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *algo_names[] = {"prm", "sprm", "kprm", "lazy", "rrt"};
+
+static algorithm *algo_from_name(const char *name, uint n, float r_multi)
+{
+	if (!strcmp(name, "prm"))
+		return new prm(n, r_multi);
+	if (!strcmp(name, "sprm"))
+		return new s_prm(n, r_multi);
+	if (!strcmp(name, "kprm"))
+		return new k_prm(n);
+	if (!strcmp(name, "lazy"))
+		return new lazy_prm(n, r_multi);
+	if (!strcmp(name, "rrt"))
+		return new rrt_connect(n, r_multi);
+	return NULL;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0)
+{
+	auto t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+static void usage(const char *exe)
+{
+	fprintf(stderr,
+		"usage: %s scene.data [algo] [n] [r_multi] [seed] "
+		"[threads] [stats.json|stats.csv]\nalgo:",
+		exe);
+	for (const char *name : algo_names)
+		fprintf(stderr, " %s", name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char *algo_name = argc > 2 ? argv[2] : "prm";
+	uint n = argc > 3 ? atoi(argv[3]) : 1000;
+	float r_multi = argc > 4 ? atof(argv[4]) : 0.1f;
+	uint seed = argc > 5 ? atoi(argv[5]) : 0;
+	uint num_threads = argc > 6 ? atoi(argv[6]) : 0;
+	const char *stats_path = argc > 7 ? argv[7] : NULL;
+
+	std::unique_ptr<system_nd> sys(get_from_file(argv[1]));
+	if (!sys) {
+		fprintf(stderr, "can't load a scene from %s\n", argv[1]);
+		return 1;
+	}
+
+	std::unique_ptr<algorithm> algo(algo_from_name(algo_name, n, r_multi));
+	if (!algo) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	algo->set_seed(seed);
+	algo->set_num_threads(num_threads);
+
+	/* Same steps as the GUI: start, proceed until done, find path */
+	auto t0 = std::chrono::steady_clock::now();
+	std::unique_ptr<graph> roadmap(algo->init_algo(sys.get()));
+	while (algo->continue_map(roadmap.get()))
+		;
+	roadmap->freeze();
+	double build_ms = ms_since(t0);
+	uint build_calls = sys->get_num_called();
+	uint build_calls_seq = sys->get_num_called_seq();
+
+	float *start = sys->get_start();
+	float *finish = sys->get_finish();
+	t0 = std::chrono::steady_clock::now();
+	std::vector<float> path =
+	    algo->find_path(roadmap.get(), sys.get(), start, finish);
+	double query_ms = ms_since(t0);
+	uint q_size = sys->get_q_size();
+
+	printf("scene %s, %u dims, %u obstacles\n", argv[1], q_size,
+	       sys->obstacles.get_num_circles());
+	printf("%s n %u r_multi %.3f seed %u threads %u\n", algo_name, n,
+	       r_multi, seed, num_threads);
+	printf("build %10.2f ms, %u vertices, %u edges, %u components\n",
+	       build_ms, roadmap->get_num_verts(), roadmap->get_num_edges(),
+	       roadmap->get_num_components());
+	printf("build valid_cfg %u, valid_cfg_seq %u\n", build_calls,
+	       build_calls_seq);
+	printf("query %10.2f ms, %s, %zu waypoints\n", query_ms,
+	       path.empty() ? "no path" : "found", path.size() / q_size);
+	printf("query valid_cfg %u, valid_cfg_seq %u\n",
+	       sys->get_num_called() - build_calls,
+	       sys->get_num_called_seq() - build_calls_seq);
+
+	if (!STATS_COMPILED_IN)
+		return 0;
+
+	stats_snapshot stats = get_planner_stats().snapshot();
+	for (uint p = 0; p < NUM_PHASES; p++)
+		printf("%-16s %10.2f ms %10llu times\n",
+		       phase_name((stats_phase)p), stats.phases[p].ms(),
+		       (unsigned long long)stats.phases[p].count);
+	for (uint c = 0; c < NUM_CHECKS; c++) {
+		const check_totals &totals = stats.checks[c];
+		printf("%-16s %10llu calls, %5.1f%% rejected, mean %.0f ns, "
+		       "p50 < %llu ns, p99 < %llu ns\n",
+		       check_name((stats_check)c),
+		       (unsigned long long)totals.calls,
+		       100.f * totals.reject_rate(), totals.mean_ns(),
+		       (unsigned long long)totals.percentile_ns(0.5f),
+		       (unsigned long long)totals.percentile_ns(0.99f));
+	}
+
+	if (stats_path) {
+		std::ofstream file(stats_path);
+		uint len = strlen(stats_path);
+
+		if (len > 4 && !strcmp(stats_path + len - 4, ".csv"))
+			write_stats_csv(stats, file);
+		else
+			write_stats_json(stats, file);
+	}
+
+	return 0;
+}
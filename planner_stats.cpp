@@ -0,0 +1,170 @@
+#include "planner_stats.hpp"
+#include <algorithm>
+
+static const char *phase_names[NUM_PHASES] = {
+    "sampling", "neighbour_search", "edge_validation", "union_find", "query"};
+
+static const char *check_names[NUM_CHECKS] = {"valid_cfg", "valid_cfg_seq"};
+
+const char *phase_name(stats_phase phase) { return phase_names[phase]; }
+
+const char *check_name(stats_check check) { return check_names[check]; }
+
+uint64_t check_totals::percentile_ns(float fraction) const
+{
+	uint64_t seen = 0;
+
+	for (uint b = 0; b < STATS_BUCKETS; b++) {
+		seen += hist[b];
+		if (seen && seen >= fraction * calls)
+			return 2ull << b;
+	}
+
+	return 0;
+}
+
+static uint bucket_of(uint64_t ns)
+{
+	uint b = 0;
+
+	while ((ns >>= 1) && b < STATS_BUCKETS - 1)
+		b++;
+	return b;
+}
+
+void planner_stats::set_threads(uint num_threads)
+{
+	if (std::max(num_threads, 1u) == shards.size())
+		reset();
+	else
+		shards.resize(num_threads);
+}
+
+void planner_stats::reset()
+{
+	for (uint i = 0; i < shards.size(); i++) {
+		shard &s = shards[i];
+
+		for (uint p = 0; p < NUM_PHASES; p++) {
+			s.phase_ns[p] = 0;
+			s.phase_count[p] = 0;
+		}
+		for (uint c = 0; c < NUM_CHECKS; c++) {
+			s.calls[c] = 0;
+			s.rejected[c] = 0;
+			s.check_ns[c] = 0;
+			for (auto &bucket : s.hist[c])
+				bucket = 0;
+		}
+	}
+}
+
+void planner_stats::add_phase(stats_phase phase, uint64_t ns)
+{
+	shard &s = shards.local();
+
+	s.phase_ns[phase].fetch_add(ns, std::memory_order_relaxed);
+	s.phase_count[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+void planner_stats::add_check(stats_check check, uint64_t ns, bool valid)
+{
+	shard &s = shards.local();
+
+	s.calls[check].fetch_add(1, std::memory_order_relaxed);
+	s.rejected[check].fetch_add(!valid, std::memory_order_relaxed);
+	s.check_ns[check].fetch_add(ns, std::memory_order_relaxed);
+	s.hist[check][bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+stats_snapshot planner_stats::snapshot()
+{
+	stats_snapshot out = {};
+
+	for (uint i = 0; i < shards.size(); i++) {
+		shard &s = shards[i];
+
+		for (uint p = 0; p < NUM_PHASES; p++) {
+			out.phases[p].ns += s.phase_ns[p];
+			out.phases[p].count += s.phase_count[p];
+		}
+		for (uint c = 0; c < NUM_CHECKS; c++) {
+			check_totals &totals = out.checks[c];
+
+			totals.calls += s.calls[c];
+			totals.rejected += s.rejected[c];
+			totals.ns += s.check_ns[c];
+			for (uint b = 0; b < STATS_BUCKETS; b++)
+				totals.hist[b] += s.hist[c][b];
+		}
+	}
+
+	return out;
+}
+
+planner_stats &get_planner_stats()
+{
+	static planner_stats stats;
+	return stats;
+}
+
+void write_stats_json(const stats_snapshot &stats, std::ostream &out)
+{
+	out << "{\n\t\"compiled_in\": "
+	    << (STATS_COMPILED_IN ? "true" : "false") << ",\n";
+
+	out << "\t\"phases\": {\n";
+	for (uint p = 0; p < NUM_PHASES; p++) {
+		const phase_totals &totals = stats.phases[p];
+
+		out << "\t\t\"" << phase_names[p] << "\": {\"ms\": "
+		    << totals.ms() << ", \"count\": " << totals.count << "}"
+		    << (p + 1 < NUM_PHASES ? ",\n" : "\n");
+	}
+	out << "\t},\n";
+
+	out << "\t\"checks\": {\n";
+	for (uint c = 0; c < NUM_CHECKS; c++) {
+		const check_totals &totals = stats.checks[c];
+
+		out << "\t\t\"" << check_names[c] << "\": {\"calls\": "
+		    << totals.calls << ", \"rejected\": " << totals.rejected
+		    << ", \"reject_rate\": " << totals.reject_rate()
+		    << ", \"mean_ns\": " << totals.mean_ns()
+		    << ", \"p50_ns\": " << totals.percentile_ns(0.5f)
+		    << ", \"p99_ns\": " << totals.percentile_ns(0.99f)
+		    << ",\n\t\t\t\"hist_log2_ns\": [";
+		for (uint b = 0; b < STATS_BUCKETS; b++)
+			out << (b ? ", " : "") << totals.hist[b];
+		out << "]}" << (c + 1 < NUM_CHECKS ? ",\n" : "\n");
+	}
+	out << "\t}\n}\n";
+}
+
+void write_stats_csv(const stats_snapshot &stats, std::ostream &out)
+{
+	out << "name,count,ms,rejected";
+	for (uint b = 0; b < STATS_BUCKETS; b++)
+		out << ",hist_" << b;
+	out << "\n";
+
+	for (uint p = 0; p < NUM_PHASES; p++) {
+		const phase_totals &totals = stats.phases[p];
+
+		out << phase_names[p] << "," << totals.count << ","
+		    << totals.ms() << ",";
+		for (uint b = 0; b < STATS_BUCKETS; b++)
+			out << ",";
+		out << "\n";
+	}
+
+	for (uint c = 0; c < NUM_CHECKS; c++) {
+		const check_totals &totals = stats.checks[c];
+
+		out << check_names[c] << "," << totals.calls << ","
+		    << totals.ns * 1e-6 << "," << totals.rejected;
+		for (uint b = 0; b < STATS_BUCKETS; b++)
+			out << "," << totals.hist[b];
+		out << "\n";
+	}
+}
@@ -0,0 +1,164 @@
+#ifndef PLANNER_STATS_H
+#define PLANNER_STATS_H
+
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+/*
+ * Where roadmap building and queries spend their time. Recording is only
+ * compiled in with -DPLANNER_STATS, without it the timers below are empty
+ * and the totals stay zero.
+ */
+#ifdef PLANNER_STATS
+#define STATS_COMPILED_IN true
+#else
+#define STATS_COMPILED_IN false
+#endif
+
+enum stats_phase {
+	PHASE_SAMPLING = 0,
+	PHASE_NEIGHBOURS,
+	PHASE_EDGES,
+	PHASE_UNION_FIND,
+	PHASE_QUERY,
+	NUM_PHASES
+};
+
+enum stats_check { CHECK_CFG = 0, CHECK_SEQ, NUM_CHECKS };
+
+/* Latency histograms, bucket b holds calls of [2^b, 2^(b+1)) ns */
+#define STATS_BUCKETS 32
+
+struct phase_totals {
+	uint64_t ns;
+	uint64_t count;
+
+	double ms() const { return ns * 1e-6; }
+};
+
+struct check_totals {
+	uint64_t calls;
+	uint64_t rejected;
+	uint64_t ns;
+	uint64_t hist[STATS_BUCKETS];
+
+	float reject_rate() const
+	{
+		return calls ? (float)rejected / (float)calls : 0.f;
+	}
+	double mean_ns() const { return calls ? (double)ns / calls : 0.; }
+	/* Upper end of the bucket holding the given fraction of calls */
+	uint64_t percentile_ns(float fraction) const;
+};
+
+struct stats_snapshot {
+	phase_totals phases[NUM_PHASES];
+	check_totals checks[NUM_CHECKS];
+};
+
+const char *phase_name(stats_phase phase);
+const char *check_name(stats_check check);
+
+/*
+ * Phases nest, edge checks made by a query also count as edge validation.
+ * Edge validation is the summed time of valid_cfg_seq calls, so with a
+ * thread pool it can exceed the wall time of the build. The other phases
+ * are timed on the thread that runs them.
+ */
+class planner_stats {
+      private:
+	struct shard {
+		std::atomic<uint64_t> phase_ns[NUM_PHASES];
+		std::atomic<uint64_t> phase_count[NUM_PHASES];
+		std::atomic<uint64_t> calls[NUM_CHECKS];
+		std::atomic<uint64_t> rejected[NUM_CHECKS];
+		std::atomic<uint64_t> check_ns[NUM_CHECKS];
+		std::atomic<uint64_t> hist[NUM_CHECKS][STATS_BUCKETS];
+	};
+
+	per_thread<shard> shards;
+
+      public:
+	/* Not synchronized with recording, call between runs */
+	void reset();
+	/* Also resets, one shard per thread of the pool that will record */
+	void set_threads(uint num_threads);
+	void add_phase(stats_phase phase, uint64_t ns);
+	void add_check(stats_check check, uint64_t ns, bool valid);
+	stats_snapshot snapshot();
+};
+
+/* The one all planners record into */
+planner_stats &get_planner_stats();
+
+void write_stats_json(const stats_snapshot &stats, std::ostream &out);
+/* One row per phase and check, histogram buckets as the last columns */
+void write_stats_csv(const stats_snapshot &stats, std::ostream &out);
+
+/* ImGui panel with the totals, reset and export */
+void show_planner_stats();
+
+typedef std::chrono::steady_clock stats_clock;
+
+#ifdef PLANNER_STATS
+
+/* Adds the time until it goes out of scope to phase */
+class phase_timer {
+      private:
+	stats_phase phase;
+	stats_clock::time_point t0;
+
+      public:
+	phase_timer(stats_phase phase) : phase(phase), t0(stats_clock::now())
+	{
+	}
+	~phase_timer()
+	{
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		    stats_clock::now() - t0);
+		get_planner_stats().add_phase(phase, ns.count());
+	}
+};
+
+/* Times one collision check, result() records and passes the outcome on */
+class check_timer {
+      private:
+	stats_check check;
+	stats_clock::time_point t0;
+
+      public:
+	check_timer(stats_check check) : check(check), t0(stats_clock::now())
+	{
+	}
+	bool result(bool valid)
+	{
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		    stats_clock::now() - t0);
+		get_planner_stats().add_check(check, ns.count(), valid);
+		if (check == CHECK_SEQ)
+			get_planner_stats().add_phase(PHASE_EDGES, ns.count());
+		return valid;
+	}
+};
+
+#else
+
+class phase_timer {
+      public:
+	phase_timer(stats_phase phase) {}
+};
+
+class check_timer {
+      public:
+	check_timer(stats_check check) {}
+	bool result(bool valid) { return valid; }
+};
+
+#endif
+
+#endif
@@ -15,6 +15,7 @@ template <class T> struct private_param_info {
 
 class private_params_provider {
       public:
+	virtual ~private_params_provider() {}
 	virtual uint get_params_float(float ***params,
 				      private_param_info<float> **info)
 	{
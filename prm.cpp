@@ -1,5 +1,6 @@
 #include "prm.hpp"
 #include "algo_utils.h"
+#include <algorithm>
 
 static float calc_base_radius(float lebesgue, uint dim)
 {
@@ -9,59 +10,154 @@ static float calc_base_radius(float lebesgue, uint dim)
 	       powf(lebesgue / unit_ball_volume(dim), dim_inv);
 }
 
-bool prm::continue_map_internal(graph *cur_set)
+/*
+ * PRM* radius shrinks as (log n / n)^(1/d). r_multi * base_r is the radius
+ * for the size the algorithm started with, grown roadmaps scale it from there.
+ */
+float prm::get_radius(uint dim)
 {
 	float r = r_multi * base_r;
-	/* generate vertices */
-	if (!cur_set->get_num_verts()) {
-		uint q_size = cur_set->q_size;
-		float *data = new float[q_size];
 
-		for (uint i = 0; i < n; i++) {
-		try_again:
-			for (uint j = 0; j < q_size; j++)
-				data[j] = generator->generate(ranges[j]);
+	if (n == start_n || start_n < 2)
+		return r;
 
-			if (!sys->valid_cfg(data))
-				goto try_again;
+	float scale = (logf((float)n) / (float)n) /
+		      (logf((float)start_n) / (float)start_n);
 
-			cur_set->add_vertice(data);
-		}
+	return r * powf(scale, 1.f / (float)dim);
+}
+
+/*
+ * Later vertices in index order, so each pair is considered once. Vertices
+ * added by grow_map() also connect to everything that existed before.
+ */
+void prm::get_candidates(graph *cur_set, uint idx)
+{
+	phase_timer timer(PHASE_NEIGHBOURS);
+	float r = get_radius(cur_set->q_size);
+
+	cur_set->get_in_radius(cur_set->get_vertice(idx), r * r, neighs);
+	neighs.erase(std::remove_if(neighs.begin(), neighs.end(),
+				    [&](const kd_match &m) {
+					    return (m.idx <= idx &&
+						    m.idx >= grow_start) ||
+						   m.idx >= n;
+				    }),
+		     neighs.end());
+	std::sort(neighs.begin(), neighs.end(),
+		  [](const kd_match &m1, const kd_match &m2) {
+			  return m1.idx < m2.idx;
+		  });
+}
 
-		delete data;
+bool prm::continue_map_internal(graph *cur_set)
+{
+	/* generate vertices */
+	if (!cur_set->get_num_verts()) {
+		sample_free(cur_set, n);
+		cur_set->rebuild_index();
 		return true;
 	}
 
 	if (internal_cnt >= n)
 		return false;
 
-	uint next_neigh = internal_cnt + 1;
+	if (batch_size)
+		return continue_batch(cur_set);
 
-	while (next_neigh < n) {
-		uint neigh =
-		    get_next_in_radius(cur_set, r * r, next_neigh,
-				       cur_set->get_vertice(internal_cnt));
+	get_candidates(cur_set, internal_cnt);
 
-		if (neigh >= n)
-			break;
-
-		next_neigh = neigh + 1;
+	for (auto &match : neighs) {
+		uint neigh = match.idx;
 
 		if (check_connection() &&
 		    cur_set->same_component(internal_cnt, neigh))
 			continue;
 
-		if (sys->valid_cfg_seq(cur_set->get_vertice(internal_cnt),
-				       cur_set->get_vertice(neigh)))
+		if (check_edge(cur_set->get_vertice(internal_cnt),
+			       cur_set->get_vertice(neigh)))
 			cur_set->add_edge(internal_cnt, neigh);
 	}
 
 	return ++internal_cnt < n;
 }
 
+#define EDGES_PER_TASK 64
+
+/*
+ * Same roadmap as the serial loop for batch_size vertices at once. Pairs are
+ * collected in (vertex, neighbour) order, validated in parallel and merged
+ * back in that order. A pair the serial loop would skip because its ends
+ * became connected earlier in the batch is validated but dropped here, and
+ * pairs connected before the batch starts are never validated.
+ */
+bool prm::continue_batch(graph *cur_set)
+{
+	uint batch_end = std::min(n, internal_cnt + batch_size);
+
+	batch_pairs.clear();
+	for (uint i = internal_cnt; i < batch_end; i++) {
+		get_candidates(cur_set, i);
+
+		for (auto &match : neighs) {
+			if (check_connection() &&
+			    cur_set->same_component(i, match.idx))
+				continue;
+
+			batch_pairs.push_back({i, match.idx});
+		}
+	}
+
+	uint num_pairs = batch_pairs.size();
+	uint num_tasks = (num_pairs + EDGES_PER_TASK - 1) / EDGES_PER_TASK;
+	batch_valid.assign(num_pairs, 0);
+
+	get_pool()->run(num_tasks, [&](uint task, uint) {
+		uint end = std::min(num_pairs, (task + 1) * EDGES_PER_TASK);
+
+		for (uint i = task * EDGES_PER_TASK; i < end; i++) {
+			float *v1 = cur_set->get_vertice(batch_pairs[i].first);
+			float *v2 = cur_set->get_vertice(batch_pairs[i].second);
+			batch_valid[i] = check_edge(v1, v2);
+		}
+	});
+
+	for (uint i = 0; i < num_pairs; i++) {
+		uint id1 = batch_pairs[i].first;
+		uint id2 = batch_pairs[i].second;
+
+		if (!batch_valid[i])
+			continue;
+
+		if (check_connection() && cur_set->same_component(id1, id2))
+			continue;
+
+		cur_set->add_edge(id1, id2);
+	}
+
+	internal_cnt = batch_end;
+	return internal_cnt < n;
+}
+
+/* Only the new vertices get connected, old edges and components stay */
+bool prm::grow_map_internal(graph *cur_set, uint num_new)
+{
+	if (internal_cnt < n || !num_new)
+		return false;
+
+	grow_start = n;
+	n += num_new;
+	sample_free(cur_set, num_new);
+	cur_set->rebuild_index();
+
+	return true;
+}
+
 graph *prm::init_algo_internal(system_nd *new_sys)
 {
 	internal_cnt = 0;
+	grow_start = 0;
+	start_n = n;
 	base_r =
 	    calc_base_radius(new_sys->get_lebesgue(), new_sys->get_q_size());
 
@@ -71,4 +167,57 @@ graph *prm::init_algo_internal(system_nd *new_sys)
 float prm::get_connection_radius(system_nd *sys)
 {
 	return calc_base_radius(sys->get_lebesgue(), sys->get_q_size());
-}
\ No newline at end of file
+}
+
+uint k_prm::get_k(uint num_verts, uint dim)
+{
+	if (num_verts < 2)
+		return 1;
+
+	float k = k_multi * (float)M_E * (1.f + 1.f / (float)dim) *
+		  logf((float)num_verts);
+
+	return (uint)ceilf(k);
+}
+
+/*
+ * k nearest neighbours of idx. Pairs where idx is also among the k nearest of
+ * an earlier vertex of the same round were already tried from the other side,
+ * so skip those.
+ */
+void k_prm::get_candidates(graph *cur_set, uint idx)
+{
+	phase_timer timer(PHASE_NEIGHBOURS);
+	uint k = get_k(n, cur_set->q_size);
+	float *ref = cur_set->get_vertice(idx);
+
+	/* +1 for the vertex itself */
+	cur_set->get_nearest(ref, k + 1, neighs);
+	kth_dist_sq[idx] = neighs.empty() ? 0.f : neighs.back().dist_sq;
+
+	neighs.erase(std::remove_if(neighs.begin(), neighs.end(),
+				    [&](const kd_match &m) {
+					    return m.idx == idx ||
+						   m.idx >= n ||
+						   (m.idx < idx &&
+						    m.idx >= grow_start &&
+						    m.dist_sq <=
+							kth_dist_sq[m.idx]);
+				    }),
+		     neighs.end());
+}
+
+bool k_prm::grow_map_internal(graph *cur_set, uint num_new)
+{
+	if (!prm::grow_map_internal(cur_set, num_new))
+		return false;
+
+	kth_dist_sq.resize(n, 0.f);
+	return true;
+}
+
+graph *k_prm::init_algo_internal(system_nd *new_sys)
+{
+	kth_dist_sq.assign(n, 0.f);
+	return prm::init_algo_internal(new_sys);
+}
@@ -7,15 +7,31 @@ class prm : public algorithm {
 	uint n;
 	virtual bool continue_map_internal(graph *cur_set) override;
 	virtual graph *init_algo_internal(system_nd *new_sys) override;
+	virtual bool grow_map_internal(graph *cur_set, uint num_new) override;
 	uint internal_cnt;
+	uint start_n = 0;    /* n when the algorithm was initialised */
+	uint grow_start = 0; /* first vertex added by the last grow_map() */
+	float get_radius(uint dim);
+	std::vector<kd_match> neighs;
 	virtual bool check_connection() { return true; }
+	virtual bool check_edge(float *v1, float *v2)
+	{
+		return sys->valid_cfg_seq(v1, v2);
+	}
+	virtual void get_candidates(graph *cur_set, uint idx);
+	bool continue_batch(graph *cur_set);
+	std::vector<std::pair<uint, uint>> batch_pairs;
+	std::vector<char> batch_valid;
 
       public:
 	void set_num_points(uint num_points) { n = num_points; }
 	uint get_num_points() { return n; }
 	virtual float get_connection_radius(system_nd *sys) override;
+	virtual bool can_grow() override { return true; }
 	float r_multi;
 	float base_r;
+	/* Vertices connected per step with parallel edge checks, 0 = serial */
+	uint batch_size = 0;
 	prm(uint num_points, float r_multi)
 	    : n(num_points), internal_cnt(0), r_multi(r_multi)
 	{
@@ -39,4 +55,26 @@ class s_prm : public prm {
 	s_prm(uint num_points, float r_multi) : prm(num_points, r_multi) {}
 };
 
+/* kPRM*: connect to k = k_multi * e(1 + 1/d) log n nearest neighbours */
+class k_prm : public prm {
+      protected:
+	std::vector<float> kth_dist_sq;
+	virtual bool check_connection() override { return false; }
+	virtual void get_candidates(graph *cur_set, uint idx) override;
+	virtual graph *init_algo_internal(system_nd *new_sys) override;
+	virtual bool grow_map_internal(graph *cur_set, uint num_new) override;
+
+      public:
+	float k_multi;
+	uint get_k(uint num_verts, uint dim);
+	k_prm(uint num_points, float k_multi = 1.f)
+	    : prm(num_points, 1.f), k_multi(k_multi)
+	{
+	}
+	k_prm(uint num_points, float k_multi, sampler *generator)
+	    : prm(num_points, 1.f, generator), k_multi(k_multi)
+	{
+	}
+};
+
 #endif
\ No newline at end of file
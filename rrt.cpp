@@ -0,0 +1,129 @@
+#include "rrt.hpp"
+
+static float get_diagonal(system_nd *sys)
+{
+	float *low = sys->get_dims_low();
+	float *high = sys->get_dims_high();
+	float diag_sq = 0.f;
+
+	for (uint i = 0; i < sys->get_q_size(); i++)
+		diag_sq += (high[i] - low[i]) * (high[i] - low[i]);
+
+	return sqrtf(diag_sq);
+}
+
+graph *rrt_connect::init_algo_internal(system_nd *new_sys)
+{
+	uint q_size = new_sys->get_q_size();
+	graph *g = new graph(q_size);
+
+	iter = 0;
+	active = 0;
+	connected = false;
+	step = step_multi * get_diagonal(new_sys);
+	q_rand.resize(q_size);
+	q_new.resize(q_size);
+	trees.assign(2, kd_tree(q_size));
+
+	tree_gen.reset(generator->clone());
+	tree_gen->seed(seed);
+	ctx.reset(new sample_context(new_sys, tree_gen.get(), ranges.data(),
+				     q_size, seed));
+
+	g->add_vertice(new_sys->get_start());
+	g->add_vertice(new_sys->get_finish());
+	trees[0].insert(g->vertice_data.data(), 0);
+	trees[1].insert(g->vertice_data.data(), 1);
+
+	return g;
+}
+
+/*
+ * Steps from the nearest vertex of the tree towards target. With target_id
+ * set, target is already in the graph and reaching it only adds an edge.
+ */
+rrt_connect::extend_result rrt_connect::extend(graph *cur_set, uint tree,
+					       const float *target,
+					       uint target_id, uint *new_id)
+{
+	uint q_size = cur_set->q_size;
+	float *points = cur_set->vertice_data.data();
+	uint near_id;
+	{
+		phase_timer timer(PHASE_NEIGHBOURS);
+		near_id = trees[tree].nearest(points, target);
+	}
+	float *q_near = cur_set->get_vertice(near_id);
+	float dist_sq = 0.f;
+
+	for (uint j = 0; j < q_size; j++)
+		dist_sq += (target[j] - q_near[j]) * (target[j] - q_near[j]);
+
+	float dist = sqrtf(dist_sq);
+	bool reached = dist <= step;
+
+	for (uint j = 0; j < q_size; j++)
+		q_new[j] = reached ? target[j]
+				   : q_near[j] + (target[j] - q_near[j]) *
+							 step / dist;
+
+	if (reached && target_id != kd_tree::NONE) {
+		if (!sys->valid_cfg_seq(q_near, q_new.data()))
+			return TRAPPED;
+
+		cur_set->add_edge(near_id, target_id);
+		*new_id = target_id;
+		return REACHED;
+	}
+
+	if (!sys->valid_cfg(q_new.data()) ||
+	    !sys->valid_cfg_seq(q_near, q_new.data()))
+		return TRAPPED;
+
+	*new_id = cur_set->get_num_verts();
+	cur_set->add_vertice(q_new.data());
+	cur_set->add_edge(near_id, *new_id);
+	trees[tree].insert(cur_set->vertice_data.data(), *new_id);
+
+	return reached ? REACHED : ADVANCED;
+}
+
+bool rrt_connect::continue_map_internal(graph *cur_set)
+{
+	if (connected || iter >= max_iters)
+		return false;
+
+	uint other = 1 - active;
+	uint new_id;
+	iter++;
+
+	{
+		phase_timer timer(PHASE_SAMPLING);
+		ctx->uniform(q_rand.data());
+	}
+	extend_result res =
+	    extend(cur_set, active, q_rand.data(), kd_tree::NONE, &new_id);
+
+	if (res != TRAPPED) {
+		/* extend overwrites q_new, so target a copy of the vertex */
+		std::vector<float> target(cur_set->get_vertice(new_id),
+					  cur_set->get_vertice(new_id) +
+					      cur_set->q_size);
+		uint other_id;
+
+		do {
+			res = extend(cur_set, other, target.data(), new_id,
+				     &other_id);
+		} while (res == ADVANCED);
+
+		connected = res == REACHED;
+	}
+
+	active = other;
+	return !connected && iter < max_iters;
+}
+
+float rrt_connect::get_connection_radius(system_nd *sys)
+{
+	return step_multi * get_diagonal(sys);
+}
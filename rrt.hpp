@@ -0,0 +1,42 @@
+#ifndef RRT_H
+#define RRT_H
+#include "algorithm.hpp"
+
+/*
+ * Bidirectional RRT-Connect. Vertex 0 is the start and vertex 1 the finish,
+ * every continue_map call is one iteration: extend one tree towards a random
+ * sample, then greedily connect the other tree to the new vertex. The two
+ * trees share one graph and become one component once they meet.
+ */
+class rrt_connect : public algorithm {
+      protected:
+	enum extend_result { TRAPPED, ADVANCED, REACHED };
+
+	uint max_iters;
+	uint iter = 0;
+	float step = 0.f;
+	bool connected = false;
+	uint active = 0;
+	std::vector<kd_tree> trees;
+	std::unique_ptr<sample_context> ctx;
+	sampler_ptr tree_gen;
+	std::vector<float> q_rand;
+	std::vector<float> q_new;
+
+	extend_result extend(graph *cur_set, uint tree, const float *target,
+			     uint target_id, uint *new_id);
+	virtual bool continue_map_internal(graph *cur_set) override;
+	virtual graph *init_algo_internal(system_nd *new_sys) override;
+
+      public:
+	float step_multi;
+	bool is_connected() { return connected; }
+	uint get_iterations() { return iter; }
+	virtual float get_connection_radius(system_nd *sys) override;
+	rrt_connect(uint max_iters, float step_multi)
+	    : max_iters(max_iters), step_multi(step_multi)
+	{
+	}
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "samplers.hpp"
+
+#define STREAM_BITS 24
+/*
+ * Sobol indices have 32 bits, 2^12 streams of 2^20 points each. Stream
+ * numbers past that wrap around with another scramble, so they give new
+ * points instead of repeating a lower stream.
+ */
+#define SOBOL_STREAM_BITS 20
+#define SOBOL_STREAMS (1u << (32 - SOBOL_STREAM_BITS))
+
+static const uint primes[MAX_LDS_DIM] = {2,  3,  5,  7,  11, 13, 17, 19,
+					 23, 29, 31, 37, 41, 43, 47, 53};
+
+static float radical_inverse(uint64_t index, uint base)
+{
+	double inv_base = 1.0 / base;
+	double factor = inv_base;
+	double result = 0.0;
+
+	while (index) {
+		result += (index % base) * factor;
+		index /= base;
+		factor *= inv_base;
+	}
+
+	return (float)result;
+}
+
+/* Keeps shifted coordinates in [0, 1) */
+static float wrap_unit(float val)
+{
+	val = val >= 1.f ? val - 1.f : val;
+	return val < 1.f ? val : 0.f;
+}
+
+void halton_sampler::seed(uint seed, uint stream)
+{
+	std::seed_seq seq{seed, 0x4861u};
+	std::mt19937 shift_gen(seq);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	/* Same shift for every stream so the streams do not overlap */
+	for (uint d = 0; d < MAX_LDS_DIM; d++)
+		shift[d] = seed ? unit(shift_gen) : 0.f;
+
+	index = ((uint64_t)stream << STREAM_BITS) + 1;
+	std::seed_seq fallback_seq{seed, stream};
+	fallback.seed(fallback_seq);
+}
+
+void halton_sampler::generate_batch(float *out, uint count, uint dim)
+{
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	for (uint i = 0; i < count; i++, index++) {
+		for (uint d = 0; d < dim; d++) {
+			if (d >= MAX_LDS_DIM) {
+				out[i * dim + d] = unit(fallback);
+				continue;
+			}
+
+			float val = radical_inverse(index, primes[d]);
+			out[i * dim + d] = wrap_unit(val + shift[d]);
+		}
+	}
+}
+
+/* Primitive polynomials and initial direction numbers (Joe and Kuo) */
+struct sobol_poly {
+	uint degree;
+	uint coeffs;
+	uint m[6];
+};
+
+static const sobol_poly sobol_polys[MAX_LDS_DIM - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+};
+
+struct sobol_directions {
+	uint32_t v[MAX_LDS_DIM][32];
+
+	sobol_directions()
+	{
+		/* First dimension is the van der Corput sequence */
+		for (uint b = 0; b < 32; b++)
+			v[0][b] = 1u << (31 - b);
+
+		for (uint d = 1; d < MAX_LDS_DIM; d++) {
+			const sobol_poly &poly = sobol_polys[d - 1];
+			uint s = poly.degree;
+
+			for (uint b = 0; b < s; b++)
+				v[d][b] = poly.m[b] << (31 - b);
+
+			for (uint b = s; b < 32; b++) {
+				uint32_t val = v[d][b - s] ^ (v[d][b - s] >> s);
+
+				for (uint k = 1; k < s; k++)
+					if ((poly.coeffs >> (s - 1 - k)) & 1)
+						val ^= v[d][b - k];
+
+				v[d][b] = val;
+			}
+		}
+	}
+};
+
+static const sobol_directions directions;
+
+static uint lowest_zero_bit(uint64_t val)
+{
+	uint bit = 0;
+
+	while (val & 1) {
+		val >>= 1;
+		bit++;
+	}
+
+	return bit;
+}
+
+void sobol_sampler::seed(uint seed, uint stream)
+{
+	uint wraps = stream / SOBOL_STREAMS;
+	std::vector<uint> key = {seed, 0x5362u};
+
+	if (wraps)
+		key.push_back(wraps);
+	std::seed_seq seq(key.begin(), key.end());
+	std::mt19937 scramble_gen(seq);
+
+	for (uint d = 0; d < MAX_LDS_DIM; d++)
+		scramble[d] = seed || wraps ? scramble_gen() : 0;
+
+	/* Jump straight to the stream start through its Gray code */
+	index = (uint64_t)(stream % SOBOL_STREAMS) << SOBOL_STREAM_BITS;
+	uint64_t gray = index ^ (index >> 1);
+
+	for (uint d = 0; d < MAX_LDS_DIM; d++) {
+		state[d] = 0;
+		for (uint b = 0; b < 32; b++)
+			if ((gray >> b) & 1)
+				state[d] ^= directions.v[d][b];
+	}
+
+	std::seed_seq fallback_seq{seed, stream};
+	fallback.seed(fallback_seq);
+}
+
+void sobol_sampler::generate_batch(float *out, uint count, uint dim)
+{
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	for (uint i = 0; i < count; i++) {
+		for (uint d = 0; d < dim; d++) {
+			if (d >= MAX_LDS_DIM) {
+				out[i * dim + d] = unit(fallback);
+				continue;
+			}
+
+			/* 24 bits fit a float exactly and stay below 1 */
+			uint32_t bits = (state[d] ^ scramble[d]) >> 8;
+			out[i * dim + d] = (float)bits * (1.f / (1 << 24));
+		}
+
+		uint bit = lowest_zero_bit(index++);
+		if (bit >= 32)
+			continue;
+		for (uint d = 0; d < MAX_LDS_DIM; d++)
+			state[d] ^= directions.v[d][bit];
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef SAMPLERS_H
+#define SAMPLERS_H
+
+#include "algorithm.hpp"
+
+#define MAX_LDS_DIM 16
+
+/*
+ * Low-discrepancy sequences. seed() picks a random shift per dimension (a
+ * digital XOR shift for Sobol). Halton streams start 2^24 points apart,
+ * Sobol streams 2^20 apart, see samplers.cpp. Dimensions past MAX_LDS_DIM
+ * are filled from a plain random generator.
+ */
+class halton_sampler : public sampler {
+      private:
+	uint64_t index = 1;
+	float shift[MAX_LDS_DIM] = {};
+	std::mt19937 fallback;
+
+      public:
+	virtual void seed(uint seed, uint stream) override;
+	virtual sampler *clone() override { return new halton_sampler(*this); }
+	virtual void generate_batch(float *out, uint count, uint dim) override;
+};
+
+class sobol_sampler : public sampler {
+      private:
+	uint64_t index = 0;
+	uint32_t state[MAX_LDS_DIM] = {};
+	uint32_t scramble[MAX_LDS_DIM] = {};
+	std::mt19937 fallback;
+
+      public:
+	virtual void seed(uint seed, uint stream) override;
+	virtual sampler *clone() override { return new sobol_sampler(*this); }
+	virtual void generate_batch(float *out, uint count, uint dim) override;
+};
+
+#endif
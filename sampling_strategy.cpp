@@ -0,0 +1,100 @@
+#include "sampling_strategy.hpp"
+#include "algorithm.hpp"
+#include <string.h>
+
+#define UNIT_BATCH 64
+#define MAX_STRATEGY_DIM 32
+
+sample_context::sample_context(
+    system_nd *sys, sampler *gen,
+    const std::uniform_real_distribution<float> *ranges, uint q_size,
+    uint seed, uint stream)
+    : sys(sys), gen(gen), ranges(ranges), q_size(q_size),
+      unit_buf(UNIT_BATCH * q_size), unit_next(UNIT_BATCH)
+{
+	std::seed_seq seq{seed, stream, 0x4761u};
+	offset_gen.seed(seq);
+}
+
+float *sample_context::next_unit()
+{
+	if (unit_next == UNIT_BATCH) {
+		gen->generate_batch(unit_buf.data(), UNIT_BATCH, q_size);
+		unit_next = 0;
+	}
+
+	return unit_buf.data() + q_size * unit_next++;
+}
+
+void sample_context::uniform(float *out)
+{
+	float *unit = next_unit();
+
+	for (uint j = 0; j < q_size; j++) {
+		float size = ranges[j].b() - ranges[j].a();
+		out[j] = ranges[j].a() + unit[j] * size;
+	}
+}
+
+void sample_context::gaussian(const float *center, float sigma, float *out)
+{
+	for (uint j = 0; j < q_size; j++) {
+		float scale = sigma * (ranges[j].b() - ranges[j].a());
+
+		out[j] = center[j] + normal(offset_gen) * scale;
+	}
+}
+
+bool sample_context::valid(float *cfg)
+{
+	for (uint j = 0; j < q_size; j++)
+		if (cfg[j] < ranges[j].a() || cfg[j] > ranges[j].b())
+			return false;
+
+	valid_calls++;
+	return sys->valid_cfg(cfg);
+}
+
+bool uniform_strategy::sample(sample_context *ctx, float *out)
+{
+	ctx->uniform(out);
+	return ctx->valid(out);
+}
+
+bool gaussian_strategy::sample(sample_context *ctx, float *out)
+{
+	uint q_size = ctx->get_q_size();
+	float second[MAX_STRATEGY_DIM];
+
+	ctx->uniform(out);
+	ctx->gaussian(out, sigma, second);
+
+	bool first_valid = ctx->valid(out);
+	if (first_valid == ctx->valid(second))
+		return false;
+
+	if (!first_valid)
+		memcpy(out, second, q_size * sizeof(float));
+
+	return true;
+}
+
+bool bridge_strategy::sample(sample_context *ctx, float *out)
+{
+	uint q_size = ctx->get_q_size();
+	float first[MAX_STRATEGY_DIM];
+	float second[MAX_STRATEGY_DIM];
+
+	ctx->uniform(first);
+	if (ctx->valid(first))
+		return false;
+
+	ctx->gaussian(first, sigma, second);
+	if (ctx->valid(second))
+		return false;
+
+	for (uint j = 0; j < q_size; j++)
+		out[j] = (first[j] + second[j]) / 2.f;
+
+	return ctx->valid(out);
+}
@@ -0,0 +1,83 @@
+#ifndef SAMPLING_STRATEGY_H
+#define SAMPLING_STRATEGY_H
+
+#include "shape_collections.hpp"
+#include <random>
+
+class sampler;
+
+/*
+ * Per-thread state for drawing configurations: pulls unit points from the
+ * sampler in blocks, maps them onto the limits and counts validity checks.
+ * Gaussian offsets come from a generator of their own, seeded by the same
+ * seed and stream. Taken from the sampler, the next points of a Halton or
+ * Sobol sequence would follow the center too closely to be normal.
+ */
+class sample_context {
+      private:
+	system_nd *sys;
+	sampler *gen;
+	const std::uniform_real_distribution<float> *ranges;
+	uint q_size;
+	std::vector<float> unit_buf;
+	uint unit_next;
+	std::mt19937 offset_gen;
+	std::normal_distribution<float> normal;
+
+	float *next_unit();
+
+      public:
+	uint64_t valid_calls = 0;
+
+	sample_context(system_nd *sys, sampler *gen,
+		       const std::uniform_real_distribution<float> *ranges,
+		       uint q_size, uint seed = 0, uint stream = 0);
+	uint get_q_size() { return q_size; }
+	void uniform(float *out);
+	/* center plus a normal offset with deviation sigma * range size */
+	void gaussian(const float *center, float sigma, float *out);
+	/* Configurations outside the limits count as invalid */
+	bool valid(float *cfg);
+};
+
+struct sampling_stats {
+	uint64_t valid_calls = 0;
+	uint64_t accepted = 0;
+	uint64_t fallbacks = 0; /* uniform after the strategy found none */
+
+	float calls_per_sample()
+	{
+		return accepted ? (float)valid_calls / (float)accepted : 0.f;
+	}
+};
+
+/* Shared by all sampling threads, so implementations keep no state */
+class sampling_strategy {
+      public:
+	virtual ~sampling_strategy() {}
+	/* One attempt, returns true and fills out if it produced a sample */
+	virtual bool sample(sample_context *ctx, float *out) = 0;
+};
+
+class uniform_strategy : public sampling_strategy {
+      public:
+	virtual bool sample(sample_context *ctx, float *out) override;
+};
+
+/* Keeps the free one of a close pair where exactly one is free */
+class gaussian_strategy : public sampling_strategy {
+      public:
+	float sigma;
+	gaussian_strategy(float sigma = 0.05f) : sigma(sigma) {}
+	virtual bool sample(sample_context *ctx, float *out) override;
+};
+
+/* Keeps the free midpoint of two colliding configurations */
+class bridge_strategy : public sampling_strategy {
+      public:
+	float sigma;
+	bridge_strategy(float sigma = 0.1f) : sigma(sigma) {}
+	virtual bool sample(sample_context *ctx, float *out) override;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "segment_kernel.hpp"
+#include <algorithm>
+#include <float.h>
+#ifdef HAVE_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+/*
+ * Squared distance from the circle center to the closest point of the
+ * segment against the squared radius plus margin. Kernels must evaluate this
+ * in exactly this order, without fused multiply-adds.
+ */
+static inline bool may_touch(float cx, float cy, float cr, float x1, float y1,
+			     float dx, float dy, float inv_len_sq)
+{
+	float px = cx - x1;
+	float py = cy - y1;
+	float t = (px * dx + py * dy) * inv_len_sq;
+
+	t = std::min(std::max(t, 0.f), 1.f);
+	float ex = px - t * dx;
+	float ey = py - t * dy;
+	float reach = cr + SEGMENT_MARGIN;
+
+	return ex * ex + ey * ey <= reach * reach;
+}
+
+/* Degenerate segments test their first end, and t never becomes NaN */
+static float get_inv_len_sq(float dx, float dy)
+{
+	float len_sq = dx * dx + dy * dy;
+	return len_sq >= FLT_MIN ? 1.f / len_sq : 0.f;
+}
+
+uint segment_kernel_scalar(const circle_soa &circles, uint begin, uint end,
+			   float x1, float y1, float x2, float y2)
+{
+	float dx = x2 - x1;
+	float dy = y2 - y1;
+	float inv_len_sq = get_inv_len_sq(dx, dy);
+
+	for (uint k = begin; k < end; k++)
+		if (may_touch(circles.x[k], circles.y[k], circles.r[k], x1, y1,
+			      dx, dy, inv_len_sq))
+			return k;
+
+	return end;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2"))) uint
+segment_kernel_avx2(const circle_soa &circles, uint begin, uint end, float x1,
+		    float y1, float x2, float y2)
+{
+	float dx = x2 - x1;
+	float dy = y2 - y1;
+	float inv_len_sq = get_inv_len_sq(dx, dy);
+	const __m256 v_x1 = _mm256_set1_ps(x1);
+	const __m256 v_y1 = _mm256_set1_ps(y1);
+	const __m256 v_dx = _mm256_set1_ps(dx);
+	const __m256 v_dy = _mm256_set1_ps(dy);
+	const __m256 v_inv = _mm256_set1_ps(inv_len_sq);
+	const __m256 v_zero = _mm256_setzero_ps();
+	const __m256 v_one = _mm256_set1_ps(1.f);
+	const __m256 v_margin = _mm256_set1_ps(SEGMENT_MARGIN);
+	uint k = begin;
+
+	for (; k + 8 <= end; k += 8) {
+		__m256 px = _mm256_sub_ps(_mm256_loadu_ps(&circles.x[k]), v_x1);
+		__m256 py = _mm256_sub_ps(_mm256_loadu_ps(&circles.y[k]), v_y1);
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(px, v_dx),
+						       _mm256_mul_ps(py, v_dy)),
+					 v_inv);
+
+		/* max before min, as in may_touch() */
+		t = _mm256_min_ps(_mm256_max_ps(t, v_zero), v_one);
+		__m256 ex = _mm256_sub_ps(px, _mm256_mul_ps(t, v_dx));
+		__m256 ey = _mm256_sub_ps(py, _mm256_mul_ps(t, v_dy));
+		__m256 dist_sq = _mm256_add_ps(_mm256_mul_ps(ex, ex),
+					       _mm256_mul_ps(ey, ey));
+		__m256 reach =
+		    _mm256_add_ps(_mm256_loadu_ps(&circles.r[k]), v_margin);
+		__m256 hit = _mm256_cmp_ps(
+		    dist_sq, _mm256_mul_ps(reach, reach), _CMP_LE_OQ);
+		int mask = _mm256_movemask_ps(hit);
+
+		if (mask)
+			return k + __builtin_ctz(mask);
+	}
+
+	for (; k < end; k++)
+		if (may_touch(circles.x[k], circles.y[k], circles.r[k], x1, y1,
+			      dx, dy, inv_len_sq))
+			return k;
+
+	return end;
+}
+#endif
+
+segment_kernel pick_segment_kernel()
+{
+#ifdef HAVE_AVX2_KERNEL
+	if (__builtin_cpu_supports("avx2"))
+		return segment_kernel_avx2;
+#endif
+	return segment_kernel_scalar;
+}
+
+const char *segment_kernel_name(segment_kernel kernel)
+{
+#ifdef HAVE_AVX2_KERNEL
+	if (kernel == segment_kernel_avx2)
+		return "avx2";
+#endif
+	return "scalar";
+}
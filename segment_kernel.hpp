@@ -0,0 +1,56 @@
+#ifndef SEGMENT_KERNEL_H
+#define SEGMENT_KERNEL_H
+
+#include <vector>
+
+typedef unsigned int uint;
+
+/* Circles as separate coordinate arrays, so kernels can load 8 at once */
+struct circle_soa {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> r;
+
+	uint size() const { return x.size(); }
+	void clear()
+	{
+		x.clear();
+		y.clear();
+		r.clear();
+	}
+	void push(float cx, float cy, float cr)
+	{
+		x.push_back(cx);
+		y.push_back(cy);
+		r.push_back(cr);
+	}
+};
+
+/*
+ * Circles closer than this to a segment count as touching it. Covers float
+ * rounding, so the exact test alone decides hits and misses.
+ */
+#define SEGMENT_MARGIN 1e-2f
+
+/*
+ * Index of the first circle in [begin, end) that may touch the segment
+ * (x1, y1)-(x2, y2), end if there is none. Every kernel returns the same
+ * index for the same input.
+ */
+typedef uint (*segment_kernel)(const circle_soa &circles, uint begin,
+			       uint end, float x1, float y1, float x2,
+			       float y2);
+
+uint segment_kernel_scalar(const circle_soa &circles, uint begin, uint end,
+			   float x1, float y1, float x2, float y2);
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_AVX2_KERNEL
+uint segment_kernel_avx2(const circle_soa &circles, uint begin, uint end,
+			 float x1, float y1, float x2, float y2);
+#endif
+
+/* Fastest kernel the running CPU supports */
+segment_kernel pick_segment_kernel();
+const char *segment_kernel_name(segment_kernel kernel);
+
+#endif
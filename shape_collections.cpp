@@ -1,7 +1,7 @@
 #include "shape_collections.hpp"
 #include <algorithm>
 #include <limits>
-#include <queue>
+#include <string.h>
 
 bool shape_manager::handle_mouse(SDL_Event *event)
 {
@@ -35,13 +35,43 @@ void shape_manager::add_entity(shape *shape_to_push)
 	shapes.push_back(shape_to_push);
 }
 
-void obstacle_list::add_one(circle c)
+void obstacle_list::push_circle(circle c)
 {
 	circles.push_back(std::unique_ptr<shape_circle>(
 	    new shape_circle(c.center, c.radius)));
 	gfx_mgr->add_entity(circles.back().get());
 }
 
+void obstacle_list::add_one(circle c)
+{
+	push_circle(c);
+	mark_edited();
+}
+
+world_ptr obstacle_list::get_world()
+{
+	if (world && world->version == version)
+		return world;
+
+	uint n = circles.size();
+	std::vector<circle> data(n);
+	collision_world *new_world = new collision_world;
+
+	apply_transforms();
+	new_world->version = version;
+	new_world->shapes.reset(new shape_circle[n]);
+	for (uint i = 0; i < n; i++) {
+		data[i] = circles[i]->get_data();
+		new_world->shapes[i] =
+		    shape_circle(data[i].center, data[i].radius);
+	}
+	new_world->grid.rebuild(data);
+	new_world->sdf.rebuild(new_world->grid);
+
+	world.reset(new_world);
+	return world;
+}
+
 static circle circle_from_file(std::ifstream &file)
 {
 	circle c;
@@ -70,6 +100,27 @@ void obstacle_list::apply_transforms()
 {
 	for (auto &c : circles)
 		c->apply_transform();
+	seen_offsets.assign(circles.size(), {0.f, 0.f});
+}
+
+/* Drags only change the pending transform, applying it clears that again */
+void obstacle_list::check_moved()
+{
+	bool moved = false;
+
+	seen_offsets.resize(circles.size(), {0.f, 0.f});
+	for (uint i = 0; i < circles.size(); i++) {
+		point offset = circles[i]->get_offset();
+
+		if (offset.x != seen_offsets[i].x ||
+		    offset.y != seen_offsets[i].y) {
+			seen_offsets[i] = offset;
+			moved = true;
+		}
+	}
+
+	if (moved)
+		mark_edited();
 }
 
 shape_circle *obstacle_list::get_circle(uint idx) { return circles[idx].get(); }
@@ -95,12 +146,54 @@ void obstacle_list::fill_from_file(std::ifstream &file)
 
 	for (uint i = 0; i < num_circles; i++) {
 		circle c = circle_from_file(file);
-		add_one(c);
+		push_circle(c);
 	}
+
+	mark_edited();
+}
+
+void system_nd::reset_counter()
+{
+	for (uint i = 0; i < num_called.size(); i++) {
+		num_called[i].cfg = 0;
+		num_called[i].seq = 0;
+	}
+}
+
+uint system_nd::get_num_called()
+{
+	uint total = 0;
+
+	for (uint i = 0; i < num_called.size(); i++)
+		total += num_called[i].cfg;
+	return total;
+}
+
+uint system_nd::get_num_called_seq()
+{
+	uint total = 0;
+
+	for (uint i = 0; i < num_called.size(); i++)
+		total += num_called[i].seq;
+	return total;
+}
+
+/* The totals so far carry over */
+void system_nd::set_threads(uint num_threads)
+{
+	if (std::max(num_threads, 1u) == num_called.size())
+		return;
+
+	uint calls = get_num_called();
+	uint calls_seq = get_num_called_seq();
+	num_called.resize(num_threads);
+	num_called[0].cfg = calls;
+	num_called[0].seq = calls_seq;
 }
 
 void system_nd::draw(float *q_vec)
 {
+	refresh_world();
 	pre_draw(q_vec);
 	gfx_mgr.draw();
 }
@@ -114,13 +207,97 @@ void system_nd::save(std::string system_name)
 	obstacles.save_as(file);
 }
 
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
+
+/* FNV-1a over everything the validity checks read */
+uint64_t system_nd::scene_key()
+{
+	uint64_t key = 14695981039346656037ull;
+	uint q_size = get_q_size();
+	uint64_t param_hash = get_param_hash();
+	float **floats;
+	int **ints;
+	private_param_info<float> *float_info;
+	private_param_info<int> *int_info;
+	uint num_floats = get_params_float(&floats, &float_info);
+	uint num_ints = get_params_int(&ints, &int_info);
+
+	key = hash_bytes(key, &world->version, sizeof(world->version));
+	key = hash_bytes(key, &q_size, sizeof(q_size));
+	key = hash_bytes(key, get_dims_low(), q_size * sizeof(float));
+	key = hash_bytes(key, get_dims_high(), q_size * sizeof(float));
+	for (uint i = 0; i < num_floats; i++)
+		key = hash_bytes(key, floats[i], sizeof(float));
+	for (uint i = 0; i < num_ints; i++)
+		key = hash_bytes(key, ints[i], sizeof(int));
+
+	return hash_bytes(key, &param_hash, sizeof(param_hash));
+}
+
+void system_nd::refresh_world()
+{
+	world = obstacles.get_world();
+	if (!occupancy && !edge_results)
+		return;
+
+	uint64_t key = scene_key();
+	if (occupancy && occupancy->key != key)
+		occupancy.reset();
+	if (edge_results)
+		edge_results->set_scene(key);
+}
+
+void system_nd::use_edge_cache(bool enable)
+{
+	if (!enable) {
+		edge_results.reset();
+		return;
+	}
+
+	if (!edge_results) {
+		edge_results.reset(new edge_cache(get_q_size()));
+		edge_results->set_scene(scene_key());
+	}
+}
+
+void system_nd::build_occupancy(thread_pool *pool)
+{
+	uint q_size = get_q_size();
+
+	refresh_world();
+	if (q_size > MAX_CSPACE_DIM) {
+		occupancy.reset();
+		return;
+	}
+
+	uint64_t key = scene_key();
+	if (occupancy && occupancy->key == key)
+		return;
+
+	cspace_grid *grid =
+	    new cspace_grid(q_size, get_dims_low(), get_dims_high(), key);
+	grid->fill(pool, [&](const float *low, const float *high) {
+		return classify_cell(low, high);
+	});
+	occupancy.reset(grid);
+}
+
 bool system_nd::handle_mouse(SDL_Event *event)
 {
 	bool handled = event_handled_internally(event);
 	handled = handled ? true : gfx_mgr.handle_mouse(event);
 
-	if (handled)
+	if (handled) {
 		correct_moved_objects();
+		obstacles.check_moved();
+	}
 
 	return handled;
 }
@@ -181,42 +358,115 @@ void system_2d::pre_draw(float *q_vec)
 bool system_2d::valid_cfg_internal(float *cfg_coords)
 {
 	circle c = {{cfg_coords[0], cfg_coords[1]}, start.get_data().radius};
-	for (uint i = 0; i < obstacles.get_num_circles(); i++)
-		if (obstacles.get_circle(i)->intersects_another_circle(&c))
-			return false;
 
-	return true;
+	return !world->grid.any_near_disc(c, [&](uint i) {
+		return world->shapes[i].intersects_another_circle(&c);
+	});
 }
 
-bool system_2d::valid_cfg_seq_internal(float *cfg_1, float *cfg_2)
+/* Robot swept along the segment, without the discs at its ends */
+static bool swept_hits(const collision_world &world, point a, point b,
+		       float robot_r)
 {
-	float x1 = cfg_1[0];
-	float x2 = cfg_2[0];
-	float y1 = cfg_1[1];
-	float y2 = cfg_2[1];
-
-	float v_x = -(y2 - y1);
-	float v_y = x2 - x1;
+	float v_x = -(b.y - a.y);
+	float v_y = b.x - a.x;
 
 	float len = sqrtf(v_x * v_x + v_y * v_y);
 
-	v_x = v_x * start.get_data().radius / len;
-	v_y = v_y * start.get_data().radius / len;
+	v_x = v_x * robot_r / len;
+	v_y = v_y * robot_r / len;
 
-	point p1 = {x1 - v_x, y1 - v_y};
-	point p2 = {x1 + v_x, y1 + v_y};
-	point p3 = {x2 - v_x, y2 - v_y};
-	point p4 = {x2 + v_x, y2 + v_y};
+	point p1 = {a.x - v_x, a.y - v_y};
+	point p2 = {a.x + v_x, a.y + v_y};
+	point p3 = {b.x - v_x, b.y - v_y};
+	point p4 = {b.x + v_x, b.y + v_y};
 
-	tri tri_1 = {p1, p2, p4};
+	tri tri_1 = {p1, p2, p3};
 	tri tri_2 = {p2, p4, p3};
 
-	for (uint i = 0; i < obstacles.get_num_circles(); i++)
-		if (obstacles.get_circle(i)->intersects_tri(&tri_1) ||
-		    obstacles.get_circle(i)->intersects_tri(&tri_2))
-			return false;
+	return world.grid.any_near_segment(a, b, robot_r, [&](uint i) {
+		shape_circle &obstacle = world.shapes[i];
+		return obstacle.intersects_tri(&tri_1) ||
+		       obstacle.intersects_tri(&tri_2);
+	});
+}
 
-	return true;
+/*
+ * Clearance around the robot certifies stretches from both ends, only the
+ * part in between is swept exactly. Its ends are certified free, so that
+ * gives the same answer as sweeping the whole edge.
+ */
+bool system_2d::valid_cfg_seq_internal(float *cfg_1, float *cfg_2)
+{
+	float robot_r = start.get_data().radius;
+	float dx = cfg_2[0] - cfg_1[0];
+	float dy = cfg_2[1] - cfg_1[1];
+	float len = sqrtf(dx * dx + dy * dy);
+	float lo;
+	float hi;
+
+	advance_edge(
+	    [&](float t, float) {
+		    point p = {cfg_1[0] + t * dx, cfg_1[1] + t * dy};
+		    float c = world->sdf.clearance(world->grid, p) - robot_r -
+			      SDF_MARGIN;
+		    return len > 0.f ? c / len : (c > 0.f ? 1.f : 0.f);
+	    },
+	    1.f / MAX_ADVANCE_STEPS, &lo, &hi);
+
+	if (lo >= hi)
+		return true;
+
+	point a = {cfg_1[0] + lo * dx, cfg_1[1] + lo * dy};
+	point b = {cfg_1[0] + hi * dx, cfg_1[1] + hi * dy};
+	return !swept_hits(*world, a, b, robot_r);
+}
+
+/*
+ * Robot centers fill the box, so the nearest and farthest box points to an
+ * obstacle center decide whether some or all of the robots touch it.
+ */
+cell_state system_2d::classify_cell(const float *low, const float *high)
+{
+	float robot_r = start.get_data().radius;
+	float half_w = (high[0] - low[0]) * 0.5f;
+	float half_h = (high[1] - low[1]) * 0.5f;
+	point mid = {low[0] + half_w, low[1] + half_h};
+	float half_diag = sqrtf(half_w * half_w + half_h * half_h);
+	circle reach = {mid, robot_r + half_diag + CELL_MARGIN};
+	const obstacle_grid &grid = world->grid;
+	bool mixed = false;
+
+	bool blocked = grid.any_near_disc(reach, [&](uint i) {
+		circle obstacle = grid.get(i);
+		float dx = fabsf(obstacle.center.x - mid.x);
+		float dy = fabsf(obstacle.center.y - mid.y);
+		float near_x = std::max(dx - half_w, 0.f);
+		float near_y = std::max(dy - half_h, 0.f);
+		float far_x = dx + half_w;
+		float far_y = dy + half_h;
+		float touch = robot_r + obstacle.radius;
+
+		if (sqrtf(far_x * far_x + far_y * far_y) < touch - CELL_MARGIN)
+			return true;
+		if (sqrtf(near_x * near_x + near_y * near_y) <=
+		    touch + CELL_MARGIN)
+			mixed = true;
+		return false;
+	});
+
+	if (blocked)
+		return CELL_BLOCKED;
+	return mixed ? CELL_MIXED : CELL_FREE;
+}
+
+uint64_t system_2d::get_param_hash()
+{
+	float robot_r = start.get_data().radius;
+	uint32_t bits;
+
+	memcpy(&bits, &robot_r, sizeof(bits));
+	return bits;
 }
 
 void system_2d::save_tool(std::ofstream &file)
@@ -245,22 +495,20 @@ system_2d::system_2d(std::ifstream &file) : system_2d()
 
 float *system_2d::get_start()
 {
-	float *data = new float[2];
 	start.apply_transform();
 	circle c = start.get_data();
-	data[0] = c.center.x;
-	data[1] = c.center.y;
-	return data;
+	start_cfg[0] = c.center.x;
+	start_cfg[1] = c.center.y;
+	return start_cfg;
 }
 
 float *system_2d::get_finish()
 {
-	float *data = new float[2];
 	finish.apply_transform();
 	circle c = finish.get_data();
-	data[0] = c.center.x;
-	data[1] = c.center.y;
-	return data;
+	finish_cfg[0] = c.center.x;
+	finish_cfg[1] = c.center.y;
+	return finish_cfg;
 }
 
 system_nd *get_from_file(std::string path_name)
@@ -297,39 +545,130 @@ float *graph::get_vertice(uint idx)
 	return all_data + idx * q_size;
 }
 
-static uint get_component(std::vector<uint> &ccs, uint id)
+void graph::add_edge(uint id1, uint id2)
+{
+	if (frozen)
+		thaw();
+
+	float *data_1 = get_vertice(id1);
+	float *data_2 = get_vertice(id2);
+	float dist_sq = 0.f;
+	for (uint d = 0; d < q_size; d++)
+		dist_sq += (data_1[d] - data_2[d]) * (data_1[d] - data_2[d]);
+
+	groups[id1].push_back(id2);
+	groups[id2].push_back(id1);
+	weights[id1].push_back(sqrtf(dist_sq));
+	weights[id2].push_back(sqrtf(dist_sq));
+
+	phase_timer timer(PHASE_UNION_FIND);
+	components.unite(id1, id2);
+}
+
+bool graph::same_component(uint id1, uint id2)
+{
+	phase_timer timer(PHASE_UNION_FIND);
+	return components.same(id1, id2);
+}
+
+void graph::remove_edge(uint id1, uint id2)
 {
-	uint root = id;
-	while (ccs[root] != root)
-		root = ccs[root];
+	if (frozen)
+		thaw();
 
-	/* Reduce depth */
-	while (ccs[id] != root) {
-		uint next = id;
-		ccs[id] = root;
-		id = next;
+	remove_half_edge(id1, id2);
+	remove_half_edge(id2, id1);
+}
+
+void graph::remove_half_edge(uint from, uint to)
+{
+	auto &neighs = groups[from];
+	auto &lengths = weights[from];
+	uint kept = 0;
+
+	for (uint k = 0; k < neighs.size(); k++) {
+		if (neighs[k] == to)
+			continue;
+		neighs[kept] = neighs[k];
+		lengths[kept] = lengths[k];
+		kept++;
 	}
 
-	return root;
+	neighs.resize(kept);
+	lengths.resize(kept);
 }
 
-void graph::add_edge(uint id1, uint id2)
+void graph::rebuild_components()
 {
-	groups[id1].push_back(id2);
-	groups[id2].push_back(id1);
+	phase_timer timer(PHASE_UNION_FIND);
+	uint n = get_num_verts();
+
+	components.reset(n);
+	for (uint i = 0; i < n; i++)
+		for (uint j : neighbours(i))
+			if (j > i)
+				components.unite(i, j);
+}
+
+uint graph::get_num_edges()
+{
+	if (frozen)
+		return csr_neighs.size() / 2;
 
-	uint cc1 = get_component(connected_components, id1);
-	uint cc2 = get_component(connected_components, id2);
+	uint num_ends = 0;
+	for (auto &neighs : groups)
+		num_ends += neighs.size();
 
-	uint cc = cc1 < cc2 ? cc1 : cc2;
-	connected_components[cc1] = cc;
-	connected_components[cc2] = cc;
+	return num_ends / 2;
 }
 
-bool graph::same_component(uint id1, uint id2)
+void graph::freeze()
 {
-	return get_component(connected_components, id1) ==
-	       get_component(connected_components, id2);
+	uint n = get_num_verts();
+
+	if (frozen)
+		thaw();
+
+	csr_offsets.resize(n + 1);
+	csr_offsets[0] = 0;
+	for (uint i = 0; i < n; i++)
+		csr_offsets[i + 1] = csr_offsets[i] + groups[i].size();
+
+	csr_neighs.resize(csr_offsets[n]);
+	csr_weights.resize(csr_offsets[n]);
+
+	for (uint i = 0; i < n; i++) {
+		std::copy(groups[i].begin(), groups[i].end(),
+			  csr_neighs.begin() + csr_offsets[i]);
+		std::copy(weights[i].begin(), weights[i].end(),
+			  csr_weights.begin() + csr_offsets[i]);
+	}
+
+	std::vector<std::vector<uint>>().swap(groups);
+	std::vector<std::vector<float>>().swap(weights);
+	components.flatten();
+	frozen = true;
+}
+
+void graph::thaw()
+{
+	if (!frozen)
+		return;
+
+	uint n = get_num_verts();
+	groups.resize(n);
+	weights.resize(n);
+	for (uint i = 0; i < n; i++) {
+		groups[i].assign(csr_neighs.begin() + csr_offsets[i],
+				 csr_neighs.begin() + csr_offsets[i + 1]);
+		weights[i].assign(csr_weights.begin() + csr_offsets[i],
+				  csr_weights.begin() + csr_offsets[i + 1]);
+	}
+
+	std::vector<uint>().swap(csr_offsets);
+	std::vector<uint>().swap(csr_neighs);
+	std::vector<float>().swap(csr_weights);
+	frozen = false;
 }
 
 void draw_2d_graph(space_2d *space, graph &g)
@@ -345,13 +684,16 @@ void draw_2d_graph(space_2d *space, graph &g)
 	set_offset(&zero_offset);
 	set_rot_angle(0);
 
-	uint num_verts = g.groups.size();
+	uint num_verts = g.get_num_verts();
 
 	for (uint i = 0; i < num_verts; i++) {
 		float *first_data = g.get_vertice(i);
 		point p1 = {first_data[0], first_data[1]};
 
-		for (auto j : g.groups[i]) {
+		for (auto j : g.neighbours(i)) {
+			if (j < i)
+				continue;
+
 			float *second_data = g.get_vertice(j);
 			point p2 = {second_data[0], second_data[1]};
 			line edge = {p1, p2};
@@ -360,8 +702,7 @@ void draw_2d_graph(space_2d *space, graph &g)
 	}
 
 	for (uint i = 0; i < num_verts; i++) {
-		set_draw_color(
-		    &colors[get_component(g.connected_components, i) % 18]);
+		set_draw_color(&colors[g.get_component(i) % 18]);
 		float x = g.vertice_data[i * 2];
 		float y = g.vertice_data[i * 2 + 1];
 		circle vert = {{x, y}, 2.f};
@@ -379,166 +720,68 @@ static float get_dist_sq_nd(float *v1, float *v2, uint size)
 	return dist_sq;
 }
 
-uint get_next_in_radius(graph *g, float r_sq, uint start, float *ref)
-{
-	uint n = g->get_num_verts();
-	uint q_size = g->q_size;
-
-	for (uint i = start; i < n; i++) {
-		float *data = g->get_vertice(i);
-		float dist_sq = 0.f;
-
-		for (uint j = 0; j < q_size; j++)
-			dist_sq += powf(data[j] - ref[j], 2.f);
-
-		if (dist_sq <= r_sq)
-			return i;
+static bool attach_valid(graph *g, system_nd *sys, float *ref,
+			 kd_match &match, int8_t *known)
+{
+	/* Vertices that coincide with the query need no motion check */
+	if (*known < 0)
+		*known = match.dist_sq <= 0.f ||
+			 sys->valid_cfg_seq(ref, g->get_vertice(match.idx));
+	return *known;
+}
+
+/*
+ * Only the closest MAX_ATTACH_NEIGHS vertices within the radius are tried.
+ * A start candidate is checked only once some finish candidate shares its
+ * component, and every check result is kept in the cache, so each attachment
+ * edge is validated at most once per query.
+ */
+bool attach_path_ends(graph *g, system_nd *sys, float *start, float *finish,
+		      float con_r_sq, uint *start_neigh, uint *end_neigh,
+		      attach_cache *cache)
+{
+	attach_cache local_cache;
+	attach_cache &c = cache ? *cache : local_cache;
+
+	if (!c.ready) {
+		uint k = MAX_ATTACH_NEIGHS;
+		g->get_nearest(start, k, c.near_start, con_r_sq);
+		g->get_nearest(finish, k, c.near_finish, con_r_sq);
+		c.start_valid.assign(c.near_start.size(), -1);
+		c.finish_valid.assign(c.near_finish.size(), -1);
+		c.ready = true;
 	}
 
-	return n;
-}
+	/* Components can change between calls for the same query */
+	c.finish_comps.resize(c.near_finish.size());
+	for (uint j = 0; j < c.near_finish.size(); j++)
+		c.finish_comps[j] = g->get_component(c.near_finish[j].idx);
 
-struct dijkstra_node {
-	uint idx;
-	uint through;
-	float cost;
-};
+	for (uint i = 0; i < c.near_start.size(); i++) {
+		uint start_comp = g->get_component(c.near_start[i].idx);
 
-class dijkstra_greater {
-      public:
-	const bool operator()(const dijkstra_node &node_1,
-			      const dijkstra_node &node_2)
-	{
-		return node_1.cost > node_2.cost;
-	}
-};
-
-float get_graph_dist(graph *g, uint id1, uint id2)
-{
-	float *data_1 = g->get_vertice(id1);
-	float *data_2 = g->get_vertice(id2);
-
-	return get_dist_sq_nd(data_1, data_2, g->q_size);
-}
-
-static std::vector<uint> dijkstra_path(graph *g, uint start, uint finish)
-{
-	uint n = g->get_num_verts();
-	dijkstra_node def = {n, n, std::numeric_limits<float>::max()};
-	std::vector<dijkstra_node> cur_best_path(n, def);
-	std::vector<bool> was_visited(g->get_num_verts(), false);
-	std::priority_queue<dijkstra_node, std::vector<dijkstra_node>,
-			    dijkstra_greater>
-	    verts_to_explore;
-
-	verts_to_explore.push({start, start, 0.f});
-	bool found = false;
-
-	while (!verts_to_explore.empty()) {
-		dijkstra_node node = verts_to_explore.top();
-		verts_to_explore.pop();
-		if (was_visited[node.idx])
-			continue;
-
-		for (uint id : g->groups[node.idx]) {
-			dijkstra_node new_node = {
-			    id, node.idx,
-			    node.cost + get_graph_dist(g, node.idx, id)};
-			if (was_visited[id] ||
-			    new_node.cost >= cur_best_path[id].cost)
+		for (uint j = 0; j < c.near_finish.size(); j++) {
+			if (c.finish_comps[j] != start_comp)
 				continue;
-
-			cur_best_path[id] = new_node;
-
-			if (id == finish) {
-				found = true;
+			if (!attach_valid(g, sys, start, c.near_start[i],
+					  &c.start_valid[i]))
 				break;
-			}
+			if (!attach_valid(g, sys, finish, c.near_finish[j],
+					  &c.finish_valid[j]))
+				continue;
 
-			verts_to_explore.push(new_node);
+			*start_neigh = c.near_start[i].idx;
+			*end_neigh = c.near_finish[j].idx;
+			return true;
 		}
-
-		was_visited[node.idx] = true;
-		if (found)
-			break;
-	}
-
-	if (!found)
-		return {};
-
-	std::vector<uint> full_path;
-	uint cur_id = finish;
-	while (cur_id != start) {
-		full_path.push_back(cur_id);
-		cur_id = cur_best_path[cur_id].through;
 	}
 
-	full_path.push_back(start);
-
-	std::reverse(full_path.begin(), full_path.end());
-
-	return full_path;
+	return false;
 }
 
-struct vert_dist {
-	uint vert_id;
-	float dist;
-};
-
-bool comp_verts(vert_dist &vd1, vert_dist &vd2) { return vd1.dist < vd2.dist; }
-
-std::vector<float> build_path(graph *g, system_nd *sys, float *start,
-			      float *finish, float con_r_sq)
+std::vector<float> path_from_ids(graph *g, std::vector<uint> &id_path,
+				 float *start, float *finish)
 {
-	uint n = g->get_num_verts();
-	std::vector<vert_dist> vds_start(n);
-	std::vector<vert_dist> vds_finish(n);
-
-	for (uint i = 0; i < n; i++) {
-		float *data = g->get_vertice(i);
-		vds_start[i] = {i, get_dist_sq_nd(data, start, g->q_size)};
-		vds_finish[i] = {i, get_dist_sq_nd(data, finish, g->q_size)};
-	}
-
-	std::sort(vds_start.begin(), vds_start.end(), comp_verts);
-	std::sort(vds_finish.begin(), vds_finish.end(), comp_verts);
-
-	bool found = false;
-	uint start_neigh = 0;
-	uint end_neigh = 0;
-
-	for (uint i = 0; i < n; i++) {
-		if (vds_start[i].dist > con_r_sq)
-			break;
-
-		start_neigh = vds_start[i].vert_id;
-		found = false;
-		if (!sys->valid_cfg_seq(start, g->get_vertice(start_neigh)))
-			continue;
-
-		for (uint j = 0; j < n; j++) {
-			if (vds_finish[j].dist > con_r_sq)
-				break;
-
-			end_neigh = vds_finish[j].vert_id;
-
-			if (!g->same_component(start_neigh, end_neigh))
-				continue;
-			if (!sys->valid_cfg_seq(finish,
-						g->get_vertice(end_neigh)))
-				continue;
-			found = true;
-			break;
-		}
-
-		if (found)
-			break;
-	}
-
-	if (!found)
-		return {};
-
-	auto id_path = dijkstra_path(g, start_neigh, end_neigh);
 	std::vector<float> path((id_path.size() + 2) * g->q_size);
 
 	for (uint j = 0; j < g->q_size; j++) {
@@ -557,6 +800,21 @@ std::vector<float> build_path(graph *g, system_nd *sys, float *start,
 	return path;
 }
 
+std::vector<float> build_path(graph *g, system_nd *sys, float *start,
+			      float *finish, float con_r_sq,
+			      search_state *state)
+{
+	uint start_neigh;
+	uint end_neigh;
+
+	if (!attach_path_ends(g, sys, start, finish, con_r_sq, &start_neigh,
+			      &end_neigh))
+		return {};
+
+	auto id_path = astar_path(g, start_neigh, end_neigh, state);
+	return path_from_ids(g, id_path, start, finish);
+}
+
 void draw_path(std::vector<float> &path)
 {
 	uint num_verts = path.size() / 2;
@@ -626,11 +884,9 @@ void draw_pos(std::vector<float> &path, system_nd *sys, float percent)
 	float internal_percent =
 	    (percent - start_percent) / (end_percent - start_percent);
 
-	float *pos = new float[3];
+	std::vector<float> pos(q_size);
 	interpolate(path.data() + q_size * start_id,
-		    path.data() + q_size * end_id, internal_percent, pos,
+		    path.data() + q_size * end_id, internal_percent, pos.data(),
 		    q_size);
-	sys->draw(pos);
-
-	delete pos;
+	sys->draw(pos.data());
 }
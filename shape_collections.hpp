@@ -1,12 +1,27 @@
 #ifndef SHAPE_COLLECTIONS_H
 #define SHAPE_COLLECTIONS_H
 
+#include "cspace_grid.hpp"
+#include "disjoint_set.hpp"
+#include "distance_field.hpp"
+#include "edge_cache.hpp"
+#include "graph_search.hpp"
+#include "kd_tree.hpp"
+#include "obstacle_grid.hpp"
+#include "planner_stats.hpp"
 #include "private_params.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
 #include <fstream>
-#include <gl_sdl_shape_obj.hpp>
 #include <memory>
 #include <vector>
 
+#ifdef HEADLESS
+#include "headless_shapes.hpp"
+#else
+#include <gl_sdl_shape_obj.hpp>
+#endif
+
 class shape_manager {
       private:
 	space_2d space;
@@ -21,6 +36,20 @@ class shape_manager {
 	space_2d *get_space_ptr() { return &space; }
 };
 
+/*
+ * Obstacles as they were when taken, detached from the shapes the GUI drags
+ * around. Never changed after creation, so planner threads can keep reading
+ * one while the scene is edited and a newer snapshot is made.
+ */
+struct collision_world {
+	uint version = ~0u;
+	obstacle_grid grid;
+	distance_field sdf; /* over grid */
+	std::unique_ptr<shape_circle[]> shapes; /* by grid id */
+};
+
+typedef std::shared_ptr<const collision_world> world_ptr;
+
 class obstacle_list {
       public:
 	obstacle_list() {}
@@ -32,15 +61,51 @@ class obstacle_list {
 	bool intersects_with(shape *shape);
 	shape_manager *gfx_mgr;
 	void fill_from_file(std::ifstream &file);
+	void mark_edited() { version++; }
+	/* Marks edited if an obstacle was dragged since the last call */
+	void check_moved();
+	/* Applies transforms and snapshots, only when edited since the last */
+	world_ptr get_world();
 
       private:
 	std::vector<std::unique_ptr<shape_circle>> circles;
+	std::vector<point> seen_offsets; /* by circle, pending transforms */
+	uint version = 0;
+	world_ptr world;
+	void push_circle(circle c);
 };
 
 class system_nd : public private_params_provider {
       private:
-	uint num_called = 0;
-	uint num_called_seq = 0;
+	struct call_counts {
+		std::atomic<uint> cfg;
+		std::atomic<uint> seq;
+	};
+
+	/* valid_cfg* may be called from several threads at once */
+	per_thread<call_counts> num_called;
+
+	bool check_cfg(float *cfg_coords)
+	{
+		if (occupancy) {
+			cell_state state = occupancy->lookup(cfg_coords);
+			if (state != CELL_MIXED)
+				return state == CELL_FREE;
+		}
+		return valid_cfg_internal(cfg_coords);
+	}
+
+	bool check_cfg_seq(float *cfg_1, float *cfg_2)
+	{
+		if (occupancy && occupancy->segment_free(cfg_1, cfg_2))
+			return true;
+		if (edge_results)
+			return edge_results->get_or_check(
+			    cfg_1, cfg_2, [&](float *c1, float *c2) {
+				    return valid_cfg_seq_internal(c1, c2);
+			    });
+		return valid_cfg_seq_internal(cfg_1, cfg_2);
+	}
 
       protected:
 	virtual bool valid_cfg_internal(float *cfg_coords) = 0;
@@ -55,25 +120,57 @@ class system_nd : public private_params_provider {
 		return false;
 	}
 	virtual void correct_moved_objects() {}
+	/* Conservative, FREE or BLOCKED must hold for the whole closed box */
+	virtual cell_state classify_cell(const float *low, const float *high)
+	{
+		return CELL_MIXED;
+	}
+	/* State the checks depend on besides obstacles and private params */
+	virtual uint64_t get_param_hash() { return 0; }
+	/* Changes whenever the results of valid_cfg* may change */
+	uint64_t scene_key();
 	shape_manager gfx_mgr;
+	world_ptr world{new collision_world}; /* what valid_cfg* check */
+	std::shared_ptr<const cspace_grid> occupancy; /* for world, optional */
+	std::unique_ptr<edge_cache> edge_results; /* optional, kept over runs */
 
       public:
 	bool handle_mouse(SDL_Event *event);
 	bool valid_cfg(float *cfg_coords)
 	{
-		num_called++;
-		return valid_cfg_internal(cfg_coords);
+		check_timer timer(CHECK_CFG);
+		num_called.local().cfg.fetch_add(1, std::memory_order_relaxed);
+		return timer.result(check_cfg(cfg_coords));
 	}
 
 	bool valid_cfg_seq(float *cfg_1, float *cfg_2)
 	{
-		num_called_seq++;
-		return valid_cfg_seq_internal(cfg_1, cfg_2);
+		check_timer timer(CHECK_SEQ);
+		num_called.local().seq.fetch_add(1, std::memory_order_relaxed);
+		return timer.result(check_cfg_seq(cfg_1, cfg_2));
 	}
 
 	space_2d *get_space_ptr() { return gfx_mgr.get_space_ptr(); }
+	/*
+	 * Not thread safe, call before handing the system to workers. Drops
+	 * the occupancy grid and cached edges once obstacles or parameters
+	 * changed.
+	 */
+	void refresh_world();
+	/* Precomputes occupancy for up to MAX_CSPACE_DIM, if not up to date */
+	void build_occupancy(thread_pool *pool);
+	void drop_occupancy() { occupancy.reset(); }
+	const cspace_grid *get_occupancy() { return occupancy.get(); }
+	/* Keeps valid_cfg_seq results until the scene changes */
+	void use_edge_cache(bool enable);
+	edge_cache *get_edge_cache() { return edge_results.get(); }
 
-	void reset_counter() { num_called = 0; }
+	/* valid_cfg and valid_cfg_seq calls, see planner_stats for more */
+	void reset_counter();
+	uint get_num_called();
+	uint get_num_called_seq();
+	/* Not thread safe, one counter per thread of the pool that checks */
+	void set_threads(uint num_threads);
 	void draw(float *q_vec);
 	void save(std::string system_name);
 	obstacle_list obstacles;
@@ -82,6 +179,7 @@ class system_nd : public private_params_provider {
 	virtual uint get_q_size() = 0;
 	virtual float *get_dims_low() = 0;
 	virtual float *get_dims_high() = 0;
+	/* Owned by the system, valid until the next call */
 	virtual float *get_start() = 0;
 	virtual float *get_finish() = 0;
 	virtual float get_lebesgue();
@@ -96,8 +194,13 @@ class system_2d : public system_nd {
 	virtual void save_tool(std::ofstream &file) override;
 	virtual bool valid_cfg_seq_internal(float *cfg_1,
 					    float *cfg_2) override;
+	virtual cell_state classify_cell(const float *low,
+					 const float *high) override;
+	virtual uint64_t get_param_hash() override;
 	float dims[2] = {w, h};
 	float dims_low[2] = {0, 0};
+	float start_cfg[2];
+	float finish_cfg[2];
 
       public:
 	shape_circle start;
@@ -118,6 +221,8 @@ class system_2d : public system_nd {
 	virtual float *get_finish() override;
 };
 
+#define MAX_ARM_LINKS 16
+
 class system_planar_arm : public system_nd {
       protected:
 	virtual bool valid_cfg_internal(float *cfg_coords) override;
@@ -127,17 +232,24 @@ class system_planar_arm : public system_nd {
 					    float *cfg_2) override;
 	virtual bool event_handled_internally(SDL_Event *event);
 	virtual void correct_moved_objects();
+	virtual cell_state classify_cell(const float *low,
+					 const float *high) override;
 	bool is_line_allowed(line l);
+	bool valid_pose(float *cfg);
+	float certified_step(float *cfg, const float *link_reach, float left);
+	float max_displacement(float *cfg_1, float *cfg_2);
 
 	uint num_links = 2;
-	std::unique_ptr<float> link_len;
-	std::unique_ptr<float> start;
-	std::unique_ptr<float> finish;
-	std::unique_ptr<float> limits_low;
-	std::unique_ptr<float> limits_high;
-	std::unique_ptr<shape_circle> start_shape;
-	std::unique_ptr<shape_circle> finish_shape;
+	std::unique_ptr<float[]> link_len;
+	std::unique_ptr<float[]> start;
+	std::unique_ptr<float[]> finish;
+	std::unique_ptr<float[]> limits_low;
+	std::unique_ptr<float[]> limits_high;
+	std::unique_ptr<shape_circle[]> start_shape;
+	std::unique_ptr<shape_circle[]> finish_shape;
 	point root = {0.f, 0.f};
+	/* Largest workspace gap between poses checked along an edge */
+	float seq_tolerance = 2.f;
 
 	std::vector<float *> params_float;
 	std::vector<int *> params_int;
@@ -164,35 +276,121 @@ class system_planar_arm : public system_nd {
 
 system_nd *get_from_file(std::string path_name);
 
+struct neigh_range {
+	const uint *first;
+	const uint *last;
+	const uint *begin() const { return first; }
+	const uint *end() const { return last; }
+	uint size() const { return last - first; }
+};
+
 class graph {
+      private:
+	/* Compressed sparse rows, replace groups while frozen */
+	bool frozen = false;
+	std::vector<uint> csr_offsets;
+	std::vector<uint> csr_neighs;
+	std::vector<float> csr_weights;
+	void remove_half_edge(uint from, uint to);
+
       public:
 	uint q_size = 2;
 	std::vector<std::vector<uint>> groups; /* neighbors */
+	std::vector<std::vector<float>> weights; /* edge lengths, as groups */
 	std::vector<float> vertice_data;
-	std::vector<uint> connected_components;
+	disjoint_set components;
+	kd_tree index{q_size}; /* over vertice_data */
 	float *get_vertice(uint idx);
-	uint get_num_verts() { return groups.size(); }
+	uint get_num_verts() { return components.size(); }
+	uint get_num_edges();
+	uint get_num_components() { return components.num_components(); }
+	void reserve(uint num_verts)
+	{
+		vertice_data.reserve(num_verts * q_size);
+		groups.reserve(num_verts);
+		weights.reserve(num_verts);
+		components.reserve(num_verts);
+	}
 	void add_vertice(float *data)
 	{
-		vertice_data.reserve(vertice_data.size() + q_size);
+		if (frozen)
+			thaw();
 		for (uint i = 0; i < q_size; i++)
 			vertice_data.push_back(data[i]);
+		index.insert(vertice_data.data(), groups.size());
 		groups.push_back({});
-		connected_components.push_back(connected_components.size());
+		weights.push_back({});
+		components.add();
+	}
+
+	/*
+	 * A finished roadmap can be frozen into flat arrays, which drops the
+	 * per-vertex allocations and keeps traversal cache friendly. Any
+	 * modification thaws it back into groups.
+	 */
+	void freeze();
+	void thaw();
+	bool is_frozen() { return frozen; }
+	neigh_range neighbours(uint id)
+	{
+		if (frozen)
+			return {csr_neighs.data() + csr_offsets[id],
+				csr_neighs.data() + csr_offsets[id + 1]};
+		std::vector<uint> &neighs = groups[id];
+		return {neighs.data(), neighs.data() + neighs.size()};
+	}
+	/* Edge lengths in neighbours() order */
+	const float *neighbour_weights(uint id)
+	{
+		if (frozen)
+			return csr_weights.data() + csr_offsets[id];
+		return weights[id].data();
 	}
 
 	void add_edge(uint id1, uint id2);
+	void remove_edge(uint id1, uint id2);
 	bool same_component(uint id1, uint id2);
+	uint get_component(uint id) { return components.find(id); }
+	/* Exact again after removing edges */
+	void rebuild_components();
+	void rebuild_index() { index.rebuild(vertice_data.data()); }
+	void get_in_radius(float *ref, float r_sq, std::vector<kd_match> &out)
+	{
+		index.radius_search(vertice_data.data(), ref, r_sq, out);
+	}
+	void get_nearest(float *ref, uint k, std::vector<kd_match> &out,
+			 float max_r_sq = kd_tree::NO_LIMIT)
+	{
+		index.knn_search(vertice_data.data(), ref, k, out, max_r_sq);
+	}
 
 	graph() {}
 	graph(uint config_size) : q_size(config_size) {}
 };
 
 void draw_2d_graph(space_2d *space, graph &g);
-uint get_next_in_radius(graph *g, float r, uint start, float *ref);
 
+#define MAX_ATTACH_NEIGHS 64
+
+/* Roadmap vertices near one query's ends and what is known about them */
+struct attach_cache {
+	bool ready = false;
+	std::vector<kd_match> near_start;
+	std::vector<kd_match> near_finish;
+	std::vector<int8_t> start_valid; /* -1 until checked */
+	std::vector<int8_t> finish_valid;
+	std::vector<uint> finish_comps;
+};
+
+/* With a cache, repeated calls for the same query reuse earlier checks */
+bool attach_path_ends(graph *g, system_nd *sys, float *start, float *finish,
+		      float con_r_sq, uint *start_neigh, uint *end_neigh,
+		      attach_cache *cache = nullptr);
+std::vector<float> path_from_ids(graph *g, std::vector<uint> &id_path,
+				 float *start, float *finish);
 std::vector<float> build_path(graph *g, system_nd *sys, float *start,
-			      float *finish, float con_r_sq);
+			      float *finish, float con_r_sq,
+			      search_state *state = nullptr);
 void draw_path(std::vector<float> &path);
 void draw_pos(std::vector<float> &path, system_nd *sys, float percent);
 
@@ -0,0 +1,79 @@
+#include "planner_stats.hpp"
+#include "imgui.h"
+#include <algorithm>
+#include <float.h>
+#include <fstream>
+#include <stdio.h>
+#include <string>
+
+static void show_check(const check_totals &totals, const char *name)
+{
+	float hist[STATS_BUCKETS];
+	uint first = STATS_BUCKETS;
+	uint last = 0;
+
+	ImGui::Text("%s: %llu calls, %.1f%% rejected", name,
+		    (unsigned long long)totals.calls,
+		    100.f * totals.reject_rate());
+	if (!totals.calls)
+		return;
+
+	ImGui::Text("  mean %.2f us, p50 < %.2f us, p99 < %.2f us",
+		    totals.mean_ns() * 1e-3, totals.percentile_ns(0.5f) * 1e-3,
+		    totals.percentile_ns(0.99f) * 1e-3);
+
+	for (uint b = 0; b < STATS_BUCKETS; b++) {
+		hist[b] = (float)totals.hist[b];
+		if (totals.hist[b]) {
+			first = std::min(first, b);
+			last = b;
+		}
+	}
+
+	/* Only the occupied range, labelled by its ends */
+	std::string label = std::string("##") + name;
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "2^%u .. 2^%u ns", first, last + 1);
+	ImGui::PlotHistogram(label.c_str(), hist + first, last - first + 1, 0,
+			     overlay, 0.f, FLT_MAX, ImVec2(0, 60));
+}
+
+void show_planner_stats()
+{
+	ImGui::Begin("Planner stats");
+
+	if (!STATS_COMPILED_IN) {
+		ImGui::Text("Built without PLANNER_STATS");
+		ImGui::End();
+		return;
+	}
+
+	stats_snapshot stats = get_planner_stats().snapshot();
+
+	for (uint p = 0; p < NUM_PHASES; p++) {
+		const phase_totals &totals = stats.phases[p];
+		ImGui::Text("%-16s %10.2f ms %8llu times",
+			    phase_name((stats_phase)p), totals.ms(),
+			    (unsigned long long)totals.count);
+	}
+
+	ImGui::Separator();
+	for (uint c = 0; c < NUM_CHECKS; c++)
+		show_check(stats.checks[c], check_name((stats_check)c));
+
+	ImGui::Separator();
+	if (ImGui::Button("Reset stats"))
+		get_planner_stats().reset();
+	ImGui::SameLine();
+	if (ImGui::Button("Save JSON")) {
+		std::ofstream file("planner_stats.json");
+		write_stats_json(stats, file);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save CSV")) {
+		std::ofstream file("planner_stats.csv");
+		write_stats_csv(stats, file);
+	}
+
+	ImGui::End();
+}
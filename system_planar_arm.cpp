@@ -2,96 +2,267 @@
 
 using namespace std;
 
-static point calc_next_pos(float *angle_so_far, float angle, point prev_point,
-			   float link_len)
+static inline void sin_cos(float angle, float *sin_a, float *cos_a)
 {
-	point result = prev_point;
-
-	*angle_so_far += angle;
-	result.x += link_len * cosf(*angle_so_far);
-	result.y += link_len * sinf(*angle_so_far);
-
-	return result;
+#ifdef __GNUC__
+	__builtin_sincosf(angle, sin_a, cos_a);
+#else
+	*sin_a = sinf(angle);
+	*cos_a = cosf(angle);
+#endif
 }
 
-static unique_ptr<line> get_all_links(point start, float *angles,
-				      float *link_lens, uint num_links)
+/* joints[0] is the root, joints[i + 1] the end of link i */
+template <uint N>
+static inline void arm_joints_fixed(point root, const float *angles,
+				    const float *link_lens, uint num_links,
+				    point *joints)
 {
-	line *links = new line[num_links];
-	point prev = start;
+	uint n = N ? N : num_links;
 	float angle = 0.f;
 
-	for (uint i = 0; i < num_links; i++) {
-		links[i].start = prev;
-		links[i].end =
-		    calc_next_pos(&angle, angles[i], prev, link_lens[i]);
-		prev = links[i].end;
+	joints[0] = root;
+	for (uint i = 0; i < n; i++) {
+		float sin_a;
+		float cos_a;
+
+		angle += angles[i];
+		sin_cos(angle, &sin_a, &cos_a);
+		joints[i + 1].x = joints[i].x + link_lens[i] * cos_a;
+		joints[i + 1].y = joints[i].y + link_lens[i] * sin_a;
 	}
+}
 
-	return unique_ptr<line>(links);
+/* Unrolled for the usual small arms */
+static void arm_joints(point root, const float *angles,
+		       const float *link_lens, uint num_links, point *joints)
+{
+	switch (num_links) {
+	case 1:
+		return arm_joints_fixed<1>(root, angles, link_lens, 1, joints);
+	case 2:
+		return arm_joints_fixed<2>(root, angles, link_lens, 2, joints);
+	case 3:
+		return arm_joints_fixed<3>(root, angles, link_lens, 3, joints);
+	case 4:
+		return arm_joints_fixed<4>(root, angles, link_lens, 4, joints);
+	default:
+		return arm_joints_fixed<0>(root, angles, link_lens, num_links,
+					   joints);
+	}
 }
 
+static const segment_kernel kernel = pick_segment_kernel();
+
+/* The kernel skips circles far from the line, intersect() decides the rest */
 bool system_planar_arm::is_line_allowed(line l)
 {
-	uint obsts_num = obstacles.get_num_circles();
+	const obstacle_grid &grid = world->grid;
+	const circle_soa &slots = grid.get_slots();
+	point p1 = l.start;
+	point p2 = l.end;
+
+	return !grid.any_run_near_segment(p1, p2, 0.f, [&](uint b, uint e) {
+		uint k = b;
+
+		while ((k = kernel(slots, k, e, p1.x, p1.y, p2.x, p2.y)) < e) {
+			circle obstacle = grid.get(grid.get_slot_id(k++));
+			if (intersect(&obstacle, &l))
+				return true;
+		}
+		return false;
+	});
+}
+
+bool system_planar_arm::valid_cfg_internal(float *cfg_coords)
+{
+	return valid_pose(cfg_coords);
+}
+
+bool system_planar_arm::valid_pose(float *cfg)
+{
+	point joints[MAX_ARM_LINKS + 1];
 
-	for (uint j = 0; j < obsts_num; j++) {
-		circle obstacle = obstacles.get_circle(j)->get_data();
-		if (intersect(&obstacle, &l))
+	arm_joints(root, cfg, link_len.get(), num_links, joints);
+	for (uint i = 0; i < num_links; i++)
+		if (!is_line_allowed({joints[i], joints[i + 1]}))
 			return false;
-	}
 
 	return true;
 }
 
-bool system_planar_arm::valid_cfg_internal(float *cfg_coords)
+/*
+ * Turning joint j by d moves no point of the arm further than d times the
+ * length of the links after it, so the sum over joints bounds how far any
+ * point travels along the edge.
+ */
+float system_planar_arm::max_displacement(float *cfg_1, float *cfg_2)
 {
-	unique_ptr<line> links =
-	    get_all_links(root, cfg_coords, link_len.get(), num_links);
-	uint obsts_num = obstacles.get_num_circles();
-	obstacles.apply_transforms();
-
-	for (uint j = 0; j < obsts_num; j++) {
-		circle obstacle = obstacles.get_circle(j)->get_data();
-		for (uint i = 0; i < num_links; i++)
-			if (intersect(&obstacle, links.get() + i))
-				return false;
+	float reach = 0.f;
+	float dist = 0.f;
+
+	for (uint j = num_links; j-- > 0;) {
+		reach += link_len[j];
+		dist += fabsf(cfg_2[j] - cfg_1[j]) * reach;
 	}
 
-	return true;
+	return dist;
 }
 
-bool system_planar_arm::valid_cfg_seq_internal(float *cfg_1, float *cfg_2)
+/*
+ * Within the cell, a point of link i moves at most the half widths of
+ * joints 0..i times its distance to each of them, from where it is in the
+ * center pose. Obstacles further than that from every link of the center
+ * pose are missed by the whole cell. Never BLOCKED, a pose close to an
+ * obstacle is left to the exact check.
+ */
+cell_state system_planar_arm::classify_cell(const float *low,
+					    const float *high)
 {
-	uint num_inter_points = num_links;
-	unique_ptr<line> links_1 =
-	    get_all_links(root, cfg_1, link_len.get(), num_links);
+	const obstacle_grid &grid = world->grid;
+	float mid[MAX_CSPACE_DIM] = {};
+	point joints[MAX_ARM_LINKS + 1];
+	float turn = 0.f;
+	float reach = 0.f;
 
-	auto incrs = unique_ptr<float>(new float[num_links]);
-	for (uint i = 0; i < num_links; i++)
-		incrs.get()[i] =
-		    (cfg_2[i] - cfg_1[i]) / ((float)num_inter_points + 1);
+	for (uint j = 0; j < num_links; j++)
+		mid[j] = 0.5f * (low[j] + high[j]);
+	arm_joints(root, mid, link_len.get(), num_links, joints);
+
+	for (uint i = 0; i < num_links; i++) {
+		point p1 = joints[i];
+		point p2 = joints[i + 1];
+
+		turn += 0.5f * (high[i] - low[i]);
+		reach += turn * link_len[i];
+
+		float r = reach + CELL_MARGIN;
+		if (grid.any_near_segment(p1, p2, r, [&](uint idx) {
+			    const circle &c = grid.get(idx);
+			    return segment_point_dist(p1, p2, c.center) <=
+				   c.radius + r;
+		    }))
+			return CELL_MIXED;
+	}
+
+	return CELL_FREE;
+}
+
+static uint reverse_bits(uint val, uint num_bits)
+{
+	uint res = 0;
+
+	for (uint i = 0; i < num_bits; i++, val >>= 1)
+		res = (res << 1) | (val & 1);
+	return res;
+}
+
+/*
+ * Fraction of an edge the arm may move from pose cfg with every link
+ * staying clear. link_reach[i] bounds how far link i moves over the whole
+ * edge and left is the fraction still uncertified, clearance beyond that
+ * is of no use.
+ */
+float system_planar_arm::certified_step(float *cfg, const float *link_reach,
+					float left)
+{
+	point joints[MAX_ARM_LINKS + 1];
+	float step = distance_field::NO_OBSTACLE;
+
+	arm_joints(root, cfg, link_len.get(), num_links, joints);
+	for (uint i = 0; i < num_links; i++) {
+		if (link_reach[i] <= 0.f)
+			continue;
 
-	auto cfg_prev = unique_ptr<float>(new float[num_links]);
-	memcpy(cfg_prev.get(), cfg_1, num_links * sizeof(float));
-	point p_prev = links_1.get()[num_links - 1].end;
+		float target = left * link_reach[i] + SDF_MARGIN;
+		float c = world->sdf.segment_clearance(
+		    world->grid, joints[i], joints[i + 1], target);
+		step = std::min(step, (c - SDF_MARGIN) / link_reach[i]);
+	}
 
-	for (uint i = 0; i <= num_inter_points; i++) {
-		auto cfg_cur = unique_ptr<float>(new float[num_links]);
+	return step;
+}
+
+#define MAX_EDGE_STEPS (1u << 16)
+/* Poses checked before clearance is tried, most colliding edges stop here */
+#define PRECHECK_POSES 3
+/* Shorter edges are quicker checked pose by pose */
+#define ADVANCE_MIN_POSES 8
+
+/*
+ * Full arm poses spaced so that no point moves more than seq_tolerance
+ * between neighbours. Both ends go first, then a few poses in van der
+ * Corput order. Clearance then certifies poses from both ends, and the
+ * poses left in between are checked in van der Corput order too, so a
+ * collision anywhere on the edge is found after few checks. Certified
+ * poses are free, so this answers as checking every pose would.
+ */
+bool system_planar_arm::valid_cfg_seq_internal(float *cfg_1, float *cfg_2)
+{
+	float tolerance = std::max(seq_tolerance, 1e-3f);
+	float steps_f = ceilf(max_displacement(cfg_1, cfg_2) / tolerance);
+	uint steps = std::min((float)MAX_EDGE_STEPS, std::max(steps_f, 1.f));
+	float cfg[MAX_ARM_LINKS];
+	float lo = 0.f;
+	float hi = 1.f;
+
+	if (!valid_pose(cfg_2) || !valid_pose(cfg_1))
+		return false;
+
+	auto lerp = [&](float t) {
 		for (uint j = 0; j < num_links; j++)
-			cfg_cur.get()[j] = cfg_prev.get()[j] + incrs.get()[j];
+			cfg[j] = cfg_1[j] + t * (cfg_2[j] - cfg_1[j]);
+	};
 
-		unique_ptr<line> links = get_all_links(
-		    root, cfg_cur.get(), link_len.get(), num_links);
-		point p_cur = links.get()[num_links - 1].end;
-		if (!is_line_allowed({p_prev, p_cur}))
-			return false;
+	/* Poses strictly between the free poses begin and end */
+	auto check_poses = [&](uint begin, uint end, uint max_checks) {
+		uint num_bits = 0;
 
-		cfg_prev.swap(cfg_cur);
-		p_prev = p_cur;
+		while ((1u << num_bits) < end - begin)
+			num_bits++;
+
+		for (uint k = 1; k < (1u << num_bits) && max_checks; k++) {
+			uint i = begin + reverse_bits(k, num_bits);
+			if (i >= end)
+				continue;
+
+			lerp((float)i / (float)steps);
+			if (!valid_pose(cfg))
+				return false;
+			max_checks--;
+		}
+
+		return true;
+	};
+
+	if (steps < ADVANCE_MIN_POSES)
+		return check_poses(0, steps, steps);
+	if (!check_poses(0, steps, PRECHECK_POSES))
+		return false;
+
+	/* As max_displacement, link by link */
+	float link_reach[MAX_ARM_LINKS];
+	float turn = 0.f;
+	float reach = 0.f;
+
+	for (uint i = 0; i < num_links; i++) {
+		turn += fabsf(cfg_2[i] - cfg_1[i]);
+		reach += turn * link_len[i];
+		link_reach[i] = reach;
 	}
 
-	return true;
+	/* Steps under two poses are better left to valid_pose */
+	advance_edge(
+	    [&](float t, float left) {
+		    lerp(t);
+		    return certified_step(cfg, link_reach, left);
+	    },
+	    2.f / steps, &lo, &hi);
+
+	/* The margin covers rounding of lo and hi to poses */
+	if (lo >= hi)
+		return true;
+	return check_poses(floorf(lo * steps), ceilf(hi * steps), steps);
 }
 
 static color robot_red = {180, 0, 0};
@@ -109,8 +280,8 @@ void system_planar_arm::pre_draw(float *q_vec)
 		return;
 	}
 
-	unique_ptr<line> links =
-	    get_all_links(root, q_vec, link_len.get(), num_links);
+	point joints[MAX_ARM_LINKS + 1];
+	arm_joints(root, q_vec, link_len.get(), num_links, joints);
 
 	if (!valid_cfg_internal(q_vec))
 		set_draw_color(&robot_red);
@@ -130,14 +301,16 @@ void system_planar_arm::pre_draw(float *q_vec)
 	draw_circle(&node);
 
 	for (uint i = 0; i < num_links; i++) {
-		set_offset(&links.get()[i].end);
+		set_offset(&joints[i + 1]);
 		draw_circle(&node);
 	}
 
 lines:
 	set_offset(&zero_offset);
-	for (uint i = 0; i < num_links; i++)
-		draw_line(links.get() + i);
+	for (uint i = 0; i < num_links; i++) {
+		line link = {joints[i], joints[i + 1]};
+		draw_line(&link);
+	}
 }
 
 bool system_planar_arm::event_handled_internally(SDL_Event *event)
@@ -205,13 +378,15 @@ void system_planar_arm::correct_moved_objects()
 
 void system_planar_arm::init()
 {
+	/* Collision checks keep joints on the stack */
+	num_links = std::min(num_links, (uint)MAX_ARM_LINKS);
 	link_len.reset(new float[num_links]);
 	start.reset(new float[num_links]);
 	finish.reset(new float[num_links]);
 	limits_low.reset(new float[num_links]);
 	limits_high.reset(new float[num_links]);
-	params_float.reserve(3 * num_links);
-	info_float.reserve(3 * num_links);
+	params_float.reserve(3 * num_links + 1);
+	info_float.reserve(3 * num_links + 1);
 
 	for (uint i = 0; i < num_links; i++) {
 		start.get()[i] = 0.f;
@@ -235,6 +410,9 @@ void system_planar_arm::init()
 		info_float.push_back(info);
 	}
 
+	params_float.push_back(&seq_tolerance);
+	info_float.push_back({{0.1f, 50.f}, "Edge check tolerance"});
+
 	start_shape.reset(new shape_circle[num_links]);
 	finish_shape.reset(new shape_circle[num_links]);
 
@@ -252,14 +430,16 @@ void system_planar_arm::init()
 
 void system_planar_arm::gfx_mgr_init()
 {
-	unique_ptr<line> start_links =
-	    get_all_links(root, start.get(), link_len.get(), num_links);
-	unique_ptr<line> finish_links =
-	    get_all_links(root, finish.get(), link_len.get(), num_links);
+	point start_joints[MAX_ARM_LINKS + 1];
+	point finish_joints[MAX_ARM_LINKS + 1];
+
+	arm_joints(root, start.get(), link_len.get(), num_links, start_joints);
+	arm_joints(root, finish.get(), link_len.get(), num_links,
+		   finish_joints);
 
 	for (uint i = 0; i < num_links; i++) {
-		start_shape.get()[i].set_origin(start_links.get()[i].end);
-		finish_shape.get()[i].set_origin(finish_links.get()[i].end);
+		start_shape.get()[i].set_origin(start_joints[i + 1]);
+		finish_shape.get()[i].set_origin(finish_joints[i + 1]);
 	}
 }
 
@@ -294,7 +474,7 @@ system_planar_arm::system_planar_arm(ifstream &file)
 	gfx_mgr_init();
 }
 
-static void write_row(ofstream &file, unique_ptr<float> &data, uint n)
+static void write_row(ofstream &file, unique_ptr<float[]> &data, uint n)
 {
 	for (uint i = 0; i < n; i++)
 		file << data.get()[i] << (i == n - 1 ? "\n" : " ");
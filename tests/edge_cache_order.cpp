@@ -0,0 +1,51 @@
+/*
+ * An edge checked from one end has to be found again from the other, and
+ * the hit and miss counts have to add up over the shards.
+ */
+#include "../edge_cache.hpp"
+#include <stdio.h>
+
+static uint failures = 0;
+
+static void expect(bool ok, const char *what)
+{
+	if (ok)
+		return;
+	failures++;
+	fprintf(stderr, "%s\n", what);
+}
+
+int main()
+{
+	edge_cache cache(3);
+	uint num_checks = 0;
+	auto check = [&](float *c1, float *c2) {
+		num_checks++;
+		return c1[0] < 50.f;
+	};
+	float a[3] = {10.f, 20.f, 30.f};
+	float b[3] = {40.f, 5.f, 60.f};
+	float c[3] = {10.f, 20.f, 31.f};
+
+	cache.set_scene(1);
+	expect(cache.get_or_check(a, b, check), "first result");
+	expect(cache.get_or_check(b, a, check), "reversed result");
+	expect(cache.get_or_check(a, b, check), "repeated result");
+	expect(num_checks == 1, "reversed pair checked again");
+
+	/* Same first coordinates, the order has to come from a later one */
+	cache.get_or_check(c, a, check);
+	cache.get_or_check(a, c, check);
+	expect(num_checks == 2, "pair differing late checked again");
+
+	cache_stats stats = cache.get_stats();
+	expect(stats.hits == 3 && stats.misses == 2, "hit and miss counts");
+
+	cache.set_scene(2);
+	stats = cache.get_stats();
+	expect(stats.hits == 0 && stats.misses == 0, "counts after new scene");
+
+	printf("edge cache order: %u checks, %u failures\n", num_checks,
+	       failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Gaussian strategy offsets have to be standard normal and independent of
+ * the center they are added to, whichever sampler draws the centers.
+ */
+#include "../samplers.hpp"
+#include "../sampling_strategy.hpp"
+#include <math.h>
+#include <stdio.h>
+
+#define NUM_DRAWS 20000
+#define SIGMA 0.05f
+#define TOLERANCE 0.05
+
+static uint failures = 0;
+
+static void expect_near(double value, double want, const char *what,
+			const char *name, uint dim)
+{
+	if (fabs(value - want) <= TOLERANCE)
+		return;
+	failures++;
+	fprintf(stderr, "%s dim %u: %s %.3f, want %.3f\n", name, dim, what,
+		value, want);
+}
+
+static void check_offsets(sampler *gen, const char *name)
+{
+	system_2d sys;
+	std::vector<std::uniform_real_distribution<float>> ranges = {
+	    std::uniform_real_distribution<float>(0.f, sys.w),
+	    std::uniform_real_distribution<float>(0.f, sys.h)};
+	sample_context ctx(&sys, gen, ranges.data(), 2, 3, 0);
+	double sum[2] = {}, sum_sq[2] = {}, sum_cross[2] = {};
+	double c_sum[2] = {}, c_sum_sq[2] = {};
+
+	gen->seed(3, 0);
+	for (uint i = 0; i < NUM_DRAWS; i++) {
+		float center[2];
+		float offset[2];
+
+		ctx.uniform(center);
+		ctx.gaussian(center, SIGMA, offset);
+		for (uint j = 0; j < 2; j++) {
+			float size = ranges[j].b() - ranges[j].a();
+			double z = (offset[j] - center[j]) / (SIGMA * size);
+			double c = center[j] / size;
+
+			sum[j] += z;
+			sum_sq[j] += z * z;
+			sum_cross[j] += z * c;
+			c_sum[j] += c;
+			c_sum_sq[j] += c * c;
+		}
+	}
+
+	for (uint j = 0; j < 2; j++) {
+		double mean = sum[j] / NUM_DRAWS;
+		double var = sum_sq[j] / NUM_DRAWS - mean * mean;
+		double c_mean = c_sum[j] / NUM_DRAWS;
+		double c_var = c_sum_sq[j] / NUM_DRAWS - c_mean * c_mean;
+		double cov = sum_cross[j] / NUM_DRAWS - mean * c_mean;
+
+		expect_near(mean, 0., "mean", name, j);
+		expect_near(var, 1., "variance", name, j);
+		expect_near(cov / sqrt(var * c_var), 0., "correlation", name,
+			    j);
+	}
+}
+
+int main()
+{
+	sampler_imp<std::mt19937> random;
+	halton_sampler halton;
+	sobol_sampler sobol;
+
+	check_offsets(&random, "random");
+	check_offsets(&halton, "halton");
+	check_offsets(&sobol, "sobol");
+
+	printf("gaussian offsets: %u failures\n", failures);
+	return failures ? 1 : 0;
+}
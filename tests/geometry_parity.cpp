@@ -0,0 +1,134 @@
+/*
+ * Checks headless_shapes against the sdl-opengl-utils geometry the GUI links,
+ * on the same random inputs. Needs the submodule and SDL, see
+ * make check_geometry. Only cases further than EPS from the boundary count,
+ * touching is up to float rounding in either implementation.
+ */
+#include <gl_sdl_shape_obj.hpp>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+
+namespace headless {
+#include "../headless_shapes.cpp"
+}
+
+#define NUM_CASES 200000
+#define EPS 1e-3
+
+static uint failures = 0;
+
+static void expect(bool same, const char *what, uint idx)
+{
+	if (same)
+		return;
+	if (failures++ < 10)
+		fprintf(stderr, "%s differs in case %u\n", what, idx);
+}
+
+static double seg_dist(double px, double py, double x1, double y1, double x2,
+		       double y2)
+{
+	double dx = x2 - x1;
+	double dy = y2 - y1;
+	double len_sq = dx * dx + dy * dy;
+	double t = 0.;
+
+	if (len_sq > 0.)
+		t = ((px - x1) * dx + (py - y1) * dy) / len_sq;
+
+	t = t < 0. ? 0. : (t > 1. ? 1. : t);
+	return hypot(x1 + t * dx - px, y1 + t * dy - py);
+}
+
+static double tri_dist(const double *t, double px, double py)
+{
+	double d1 = (t[2] - t[0]) * (py - t[1]) - (t[3] - t[1]) * (px - t[0]);
+	double d2 = (t[4] - t[2]) * (py - t[3]) - (t[5] - t[3]) * (px - t[2]);
+	double d3 = (t[0] - t[4]) * (py - t[5]) - (t[1] - t[5]) * (px - t[4]);
+	bool has_neg = d1 < 0. || d2 < 0. || d3 < 0.;
+	bool has_pos = d1 > 0. || d2 > 0. || d3 > 0.;
+
+	if (!(has_neg && has_pos))
+		return 0.;
+	return fmin(fmin(seg_dist(px, py, t[0], t[1], t[2], t[3]),
+			 seg_dist(px, py, t[2], t[3], t[4], t[5])),
+		    seg_dist(px, py, t[4], t[5], t[0], t[1]));
+}
+
+int main()
+{
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<float> coord(0.f, 400.f);
+	std::uniform_real_distribution<float> near(-40.f, 40.f);
+	std::uniform_real_distribution<float> radius(0.5f, 30.f);
+
+	for (uint i = 0; i < NUM_CASES; i++) {
+		float cx = coord(gen), cy = coord(gen), r = radius(gen);
+		float v[6];
+		for (uint j = 0; j < 6; j += 2) {
+			v[j] = cx + near(gen);
+			v[j + 1] = cy + near(gen);
+		}
+		double t[6] = {v[0], v[1], v[2], v[3], v[4], v[5]};
+
+		/* Circle against segment */
+		circle c = {{cx, cy}, r};
+		line l = {{v[0], v[1]}, {v[2], v[3]}};
+		headless::circle hc = {{cx, cy}, r};
+		headless::line hl = {{v[0], v[1]}, {v[2], v[3]}};
+		double gap = seg_dist(cx, cy, t[0], t[1], t[2], t[3]) - r;
+		bool same = intersect(&c, &l) == headless::intersect(&hc, &hl);
+		if (fabs(gap) > EPS)
+			expect(same, "intersect(circle, line)", i);
+
+		/* Circle against circle */
+		circle other = {{v[4], v[5]}, radius(gen)};
+		headless::circle h_other = {{v[4], v[5]}, other.radius};
+		shape_circle sc(c.center, r);
+		headless::shape_circle hsc(hc.center, r);
+		gap = hypot(t[4] - cx, t[5] - cy) - r - other.radius;
+		if (fabs(gap) > EPS)
+			expect(sc.intersects_another_circle(&other) ==
+				   hsc.intersects_another_circle(&h_other),
+			       "intersects_another_circle", i);
+
+		/* Circle against triangle */
+		tri tr = {{v[0], v[1]}, {v[2], v[3]}, {v[4], v[5]}};
+		headless::tri htr = {{v[0], v[1]}, {v[2], v[3]}, {v[4], v[5]}};
+		gap = tri_dist(t, cx, cy) - r;
+		same = sc.intersects_tri(&tr) == hsc.intersects_tri(&htr);
+		if (fabs(gap) > EPS)
+			expect(same, "intersects_tri", i);
+	}
+
+	/* Transforms the way system_2d and the arm use them */
+	shape_circle sc(5.f);
+	headless::shape_circle hsc(5.f);
+	sc.move({10.f, 20.f});
+	hsc.move({10.f, 20.f});
+	sc.move({1.f, 2.f});
+	hsc.move({1.f, 2.f});
+	point off = sc.get_offset();
+	headless::point h_off = hsc.get_offset();
+	expect(off.x == h_off.x && off.y == h_off.y, "get_offset", 0);
+	sc.apply_transform();
+	hsc.apply_transform();
+	circle data = sc.get_data();
+	headless::circle h_data = hsc.get_data();
+	expect(data.center.x == h_data.center.x &&
+		   data.center.y == h_data.center.y &&
+		   data.radius == h_data.radius,
+	       "apply_transform", 0);
+	off = sc.get_offset();
+	h_off = hsc.get_offset();
+	expect(off.x == h_off.x && off.y == h_off.y, "offset after apply", 0);
+	sc.set_origin({7.f, 8.f});
+	hsc.set_origin({7.f, 8.f});
+	off = sc.get_offset();
+	h_off = hsc.get_offset();
+	expect(off.x == h_off.x && off.y == h_off.y, "set_origin", 0);
+
+	printf("%u cases, %u differences\n", NUM_CASES, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Lazy PRM has to answer a query in a cluttered scene with at most half the
+ * motion checks PRM spends building its roadmap, and every segment of the
+ * path it returns has to be valid. Planning again after each invalid edge
+ * used nearly as many as PRM in this scene.
+ */
+#include "../lazy_prm.hpp"
+#include "../prm.hpp"
+#include <memory>
+#include <random>
+#include <stdio.h>
+
+#define NUM_OBSTACLES 300
+#define NUM_POINTS 1500
+
+static system_2d *make_scene()
+{
+	circle start = {{10.f, 10.f}, 3.f};
+	circle finish = {{390.f, 215.f}, 3.f};
+	system_2d *sys = new system_2d(start, finish);
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<float> x(0.f, sys->w);
+	std::uniform_real_distribution<float> y(0.f, sys->h);
+	std::uniform_real_distribution<float> radius(2.f, 6.f);
+
+	for (uint i = 0; i < NUM_OBSTACLES; i++) {
+		circle c = {{x(gen), y(gen)}, radius(gen)};
+		float margin = c.radius + start.radius + 1.f;
+
+		if (hypotf(c.center.x - start.center.x,
+			   c.center.y - start.center.y) < margin ||
+		    hypotf(c.center.x - finish.center.x,
+			   c.center.y - finish.center.y) < margin)
+			continue;
+		sys->obstacles.add_one(c);
+	}
+
+	return sys;
+}
+
+/* Motion checks for building and one query, and the path found */
+static uint run(algorithm *algo, std::vector<float> &path)
+{
+	std::unique_ptr<system_nd> sys(make_scene());
+
+	algo->set_seed(1);
+	algo->set_num_threads(1);
+
+	std::unique_ptr<graph> roadmap(algo->init_algo(sys.get()));
+	while (algo->continue_map(roadmap.get()))
+		;
+	roadmap->freeze();
+
+	path = algo->find_path(roadmap.get(), sys.get(), sys->get_start(),
+			       sys->get_finish());
+	uint checks = sys->get_num_called_seq();
+
+	for (uint i = 2; i < path.size(); i += 2)
+		if (!sys->valid_cfg_seq(&path[i - 2], &path[i]))
+			return ~0u;
+
+	return checks;
+}
+
+int main()
+{
+	std::vector<float> prm_path;
+	std::vector<float> lazy_path;
+	prm plain(NUM_POINTS, 0.1f);
+	lazy_prm lazy(NUM_POINTS, 0.1f);
+	uint prm_checks = run(&plain, prm_path);
+	uint lazy_checks = run(&lazy, lazy_path);
+	uint failures = 0;
+
+	if (prm_path.empty() || lazy_path.empty()) {
+		failures++;
+		fprintf(stderr, "no path, prm %zu lazy %zu values\n",
+			prm_path.size(), lazy_path.size());
+	}
+	if (lazy_checks == ~0u) {
+		failures++;
+		fprintf(stderr, "lazy path crosses an obstacle\n");
+	} else if (2 * lazy_checks >= prm_checks) {
+		failures++;
+		fprintf(stderr, "lazy used %u checks, prm %u\n", lazy_checks,
+			prm_checks);
+	}
+
+	printf("lazy prm checks: prm %u, lazy %u, %u failures\n", prm_checks,
+	       lazy_checks, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * With every budget of shortcut_params at zero the optimizer has no limit of
+ * its own, it must still return once the attempt cap is reached.
+ */
+#include "../path_shortcut.hpp"
+#include <stdio.h>
+
+int main()
+{
+	system_2d sys;
+	std::vector<float> path = {10.f, 10.f, 200.f, 150.f, 300.f, 10.f,
+				   350.f, 200.f};
+	shortcut_params params;
+	uint failures = 0;
+
+	params.max_checks = 0;
+	params.max_time_ms = 0.f;
+	params.max_fails = 0;
+
+	shortcut_stats stats = shortcut_path(path, &sys, params);
+
+	if (stats.length_after > stats.length_before) {
+		failures++;
+		fprintf(stderr, "path grew from %.1f to %.1f\n",
+			stats.length_before, stats.length_after);
+	}
+	if (path.size() % 2 || path[0] != 10.f || path.back() != 200.f) {
+		failures++;
+		fprintf(stderr, "path ends moved\n");
+	}
+
+	printf("path shortcut budget: %.1f -> %.1f, %u checks, %.0f ms, "
+	       "%u failures\n",
+	       stats.length_before, stats.length_after, stats.checks,
+	       stats.time_ms, failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Distinct streams of one seed have to give distinct points, also for stream
+ * numbers past what fits the Sobol index.
+ */
+#include "../samplers.hpp"
+#include <stdio.h>
+#include <vector>
+
+#define DIM 3
+#define POINTS 64
+
+static uint failures = 0;
+
+static std::vector<float> first_points(sampler *gen, uint seed, uint stream)
+{
+	std::vector<float> out(POINTS * DIM);
+
+	gen->seed(seed, stream);
+	gen->generate_batch(out.data(), POINTS, DIM);
+	return out;
+}
+
+static void check_streams(sampler *gen, const char *name, uint seed)
+{
+	uint streams[] = {0, 1, 2, 255, 256, 257, 4095, 4096, 4097, 8192};
+	uint num = sizeof(streams) / sizeof(*streams);
+	std::vector<std::vector<float>> points;
+
+	for (uint stream : streams)
+		points.push_back(first_points(gen, seed, stream));
+
+	for (uint i = 0; i < num; i++)
+		for (uint j = i + 1; j < num; j++) {
+			if (points[i] != points[j])
+				continue;
+			failures++;
+			fprintf(stderr, "%s seed %u: streams %u and %u match\n",
+				name, seed, streams[i], streams[j]);
+		}
+}
+
+int main()
+{
+	halton_sampler halton;
+	sobol_sampler sobol;
+
+	for (uint seed : {0u, 7u}) {
+		check_streams(&halton, "halton", seed);
+		check_streams(&sobol, "sobol", seed);
+	}
+
+	printf("sampler streams: %u failures\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#include "thread_pool.hpp"
+
+static thread_local uint thread_index = 0;
+
+uint pool_thread_index() { return thread_index; }
+
+uint hardware_threads()
+{
+#ifdef __EMSCRIPTEN__
+	return 1; /* built without pthreads */
+#else
+	uint num = std::thread::hardware_concurrency();
+	return num ? num : 1;
+#endif
+}
+
+thread_pool::thread_pool(uint num_threads)
+{
+	if (!num_threads)
+		num_threads = hardware_threads();
+#ifdef __EMSCRIPTEN__
+	num_threads = 1;
+#endif
+
+	workers.reserve(num_threads - 1);
+	for (uint i = 1; i < num_threads; i++)
+		workers.emplace_back(&thread_pool::worker_loop, this, i);
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+
+	work_cv.notify_all();
+	for (auto &worker : workers)
+		worker.join();
+}
+
+void thread_pool::do_tasks(const pool_job *cur_job, uint cur_tasks,
+			   uint thread_id)
+{
+	uint task;
+
+	while ((task = next_task.fetch_add(1)) < cur_tasks)
+		(*cur_job)(task, thread_id);
+}
+
+void thread_pool::worker_loop(uint thread_id)
+{
+	uint seen = 0;
+
+	thread_index = thread_id;
+
+	while (true) {
+		const pool_job *cur_job;
+		uint cur_tasks;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			work_cv.wait(guard, [&] {
+				return stopping || generation != seen;
+			});
+
+			if (stopping)
+				return;
+
+			seen = generation;
+			cur_job = job;
+			cur_tasks = num_tasks;
+		}
+
+		do_tasks(cur_job, cur_tasks, thread_id);
+
+		std::lock_guard<std::mutex> guard(lock);
+		if (!--busy)
+			done_cv.notify_one();
+	}
+}
+
+void thread_pool::run(uint num_tasks, const pool_job &fn)
+{
+	if (workers.empty() || num_tasks < 2) {
+		for (uint i = 0; i < num_tasks; i++)
+			fn(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		job = &fn;
+		this->num_tasks = num_tasks;
+		next_task = 0;
+		busy = workers.size();
+		generation++;
+	}
+
+	work_cv.notify_all();
+	do_tasks(&fn, num_tasks, 0);
+
+	std::unique_lock<std::mutex> guard(lock);
+	done_cv.wait(guard, [&] { return !busy; });
+	job = nullptr;
+}
@@ -0,0 +1,105 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+typedef unsigned int uint;
+
+typedef std::function<void(uint task, uint thread)> pool_job;
+
+/*
+ * Fixed set of worker threads. run() hands out task indices [0, num_tasks)
+ * to the workers and the calling thread, and returns once all are done.
+ * Which thread gets which task is not deterministic, so jobs should write
+ * their results to per-task slots.
+ */
+class thread_pool {
+      private:
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+	const pool_job *job = nullptr;
+	uint num_tasks = 0;
+	std::atomic<uint> next_task{0};
+	uint busy = 0;
+	uint generation = 0;
+	bool stopping = false;
+
+	void worker_loop(uint thread_id);
+	void do_tasks(const pool_job *cur_job, uint cur_tasks, uint thread_id);
+
+      public:
+	/* num_threads includes the caller, 0 means one per hardware thread */
+	thread_pool(uint num_threads = 0);
+	~thread_pool();
+	uint size() { return workers.size() + 1; }
+	void run(uint num_tasks, const pool_job &fn);
+};
+
+uint hardware_threads();
+/* thread argument of the job running on this thread, 0 outside a pool */
+uint pool_thread_index();
+
+/*
+ * One T per thread of a pool, each on its own cache line, for data every
+ * worker updates. Threads past size() wrap around and share, so T has to
+ * stay safe for concurrent use. new[] only honours the cache line alignment
+ * from C++17 on, so the slots are aligned by hand.
+ */
+template <class T> class per_thread {
+      private:
+	struct alignas(64) slot {
+		T value;
+	};
+
+	std::unique_ptr<char[]> storage;
+	slot *slots = nullptr;
+	uint num_slots = 0;
+
+	void destroy()
+	{
+		for (uint i = 0; i < num_slots; i++)
+			slots[i].~slot();
+	}
+
+      public:
+	per_thread(uint num_threads = 1) { resize(num_threads); }
+	~per_thread() { destroy(); }
+	per_thread(const per_thread &) = delete;
+	per_thread &operator=(const per_thread &) = delete;
+
+	/* Not thread safe, all slots start over value-initialized */
+	void resize(uint num_threads)
+	{
+		destroy();
+		num_slots = num_threads ? num_threads : 1;
+		storage.reset(new char[(num_slots + 1) * sizeof(slot)]);
+
+		size_t align = alignof(slot);
+		uintptr_t addr = (uintptr_t)storage.get();
+		addr = (addr + align - 1) & ~(uintptr_t)(align - 1);
+		slots = (slot *)addr;
+		for (uint i = 0; i < num_slots; i++)
+			new (slots + i) slot();
+	}
+
+	uint size() const { return num_slots; }
+	T &operator[](uint idx) { return slots[idx].value; }
+	/* The slot of the calling pool thread */
+	T &local()
+	{
+		uint idx = pool_thread_index();
+		return slots[idx < num_slots ? idx : idx % num_slots].value;
+	}
+};
+
+#endif